@@ -0,0 +1,1236 @@
+/*
+  ==============================================================================
+
+    CompressorKernel.cpp
+
+  ==============================================================================
+*/
+
+#include "CompressorKernel.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace VocalDSP
+{
+
+namespace
+{
+    template <typename SampleType, typename Vector>
+    SampleType horizontalMax (Vector v) noexcept
+    {
+        SampleType lanes[Vector::size];
+        v.store (lanes);
+
+        auto result = lanes[0];
+
+        for (int lane = 1; lane < Vector::size; ++lane)
+            result = std::max (result, lanes[lane]);
+
+        return result;
+    }
+
+    template <typename SampleType, typename Vector>
+    SampleType horizontalMin (Vector v) noexcept
+    {
+        SampleType lanes[Vector::size];
+        v.store (lanes);
+
+        auto result = lanes[0];
+
+        for (int lane = 1; lane < Vector::size; ++lane)
+            result = std::min (result, lanes[lane]);
+
+        return result;
+    }
+
+    template <typename SampleType, typename Vector>
+    SampleType horizontalSum (Vector v) noexcept
+    {
+        SampleType lanes[Vector::size];
+        v.store (lanes);
+
+        SampleType result = 0;
+
+        for (auto lane : lanes)
+            result += lane;
+
+        return result;
+    }
+
+    /** One-pole ballistics, as in juce::dsp::BallisticsFilter. Linear signals
+        are rectified on the way in, levels in dB are smoothed as they are.
+    */
+    template <bool rectify, bool writeEnvelope, typename SampleType>
+    SampleType followLevel (const SampleType* source, SampleType* envelope, int numSamples, SampleType state,
+                            SampleType attackCoefficient, SampleType releaseCoefficient) noexcept
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const SampleType input = rectify ? std::abs (source[i]) : source[i];
+            const SampleType coefficient = input > state ? attackCoefficient : releaseCoefficient;
+
+            state = input + coefficient * (state - input);
+
+            if constexpr (writeEnvelope)
+                envelope[i] = state;
+        }
+
+        return state;
+    }
+
+    /** followLevel() for several channels at once, one per SIMDVector lane. */
+    template <bool rectify, typename SampleType>
+    void followLevels (const SampleType* const* source, SampleType* const* envelope, int numChannels, int numSamples,
+                       SampleType* states, SampleType attackCoefficient, SampleType releaseCoefficient,
+                       SampleType* scratch) noexcept
+    {
+        using Vector = SIMDVector<SampleType>;
+        constexpr int width = Vector::size;
+
+        for (int first = 0; first < numChannels; first += width)
+        {
+            const int numLanes = std::min (width, numChannels - first);
+
+            // Nothing to share a register with
+            if (numLanes == 1)
+            {
+                states[first] = followLevel<rectify, true> (source[first], envelope[first], numSamples,
+                                                            states[first], attackCoefficient, releaseCoefficient);
+                continue;
+            }
+
+            SampleType lanes[width] = {};
+
+            // Frame i holds sample i of every channel in the group, silence for the unused lanes
+            for (int lane = 0; lane < width; ++lane)
+            {
+                if (lane < numLanes)
+                {
+                    const SampleType* samples = source[first + lane];
+
+                    for (int i = 0; i < numSamples; ++i)
+                        scratch[i * width + lane] = samples[i];
+
+                    lanes[lane] = states[first + lane];
+                }
+                else
+                {
+                    for (int i = 0; i < numSamples; ++i)
+                        scratch[i * width + lane] = 0.0f;
+                }
+            }
+
+            const auto attack  = Vector::broadcast (attackCoefficient);
+            const auto release = Vector::broadcast (releaseCoefficient);
+            auto state = Vector::load (lanes);
+
+            for (int i = 0; i < numSamples * width; i += width)
+            {
+                auto input = Vector::load (scratch + i);
+
+                if constexpr (rectify)
+                    input = Vector::abs (input);
+
+                const auto coefficient = Vector::select (Vector::lessThan (state, input), attack, release);
+
+                state = input + coefficient * (state - input);
+                state.store (scratch + i);
+            }
+
+            state.store (lanes);
+
+            for (int lane = 0; lane < numLanes; ++lane)
+            {
+                SampleType* destination = envelope[first + lane];
+
+                for (int i = 0; i < numSamples; ++i)
+                    destination[i] = scratch[i * width + lane];
+
+                states[first + lane] = lanes[lane];
+            }
+        }
+    }
+
+    /** Returns the largest sample value, without rectifying. */
+    template <typename SampleType>
+    SampleType getMaximum (const SampleType* samples, int numSamples) noexcept
+    {
+        using Vector = SIMDVector<SampleType>;
+
+        SampleType maximum = samples[0];
+        int i = 0;
+
+        if (i <= numSamples - Vector::size)
+        {
+            auto maxima = Vector::load (samples);
+
+            for (i = Vector::size; i <= numSamples - Vector::size; i += Vector::size)
+                maxima = Vector::max (maxima, Vector::load (samples + i));
+
+            maximum = horizontalMax<SampleType> (maxima);
+        }
+
+        for (; i < numSamples; ++i)
+            maximum = std::max (maximum, samples[i]);
+
+        return maximum;
+    }
+}
+
+//==============================================================================
+template <typename SampleType>
+void CompressorKernel<SampleType>::prepare (double newSampleRate, int newMaximumBlockSize, int numChannels)
+{
+    sampleRate = newSampleRate;
+    maximumBlockSize = std::max (1, newMaximumBlockSize);
+    numChannels = std::max (0, numChannels);
+
+    envelopeState.assign ((size_t) numChannels, 0.0f);
+    lastGain.assign ((size_t) numChannels, -1.0f);
+
+    envelopeBuffer.assign ((size_t) (maximumBlockSize * std::max (1, numChannels)), 0.0f);
+    gainBuffer.assign ((size_t) maximumBlockSize, 0.0f);
+    controlBuffer.assign ((size_t) maximumBlockSize, 0.0f);
+    linkBuffer.assign ((size_t) maximumBlockSize, 0.0f);
+    interleaveBuffer.assign ((size_t) (maximumBlockSize * SIMDVector<SampleType>::size), 0.0f);
+
+    for (auto* ramp : { &thresholdRamp, &slopeRamp, &kneeRamp, &makeUpRamp, &makeUpGainRamp })
+        ramp->assign ((size_t) maximumBlockSize, 0.0f);
+
+    // The coefficients depend on the sample rate
+    attackMs = releaseMs = -1.0f;
+
+    activeSource.assign ((size_t) numChannels, nullptr);
+    activeEnvelope.assign ((size_t) numChannels, nullptr);
+    activeInput.assign ((size_t) numChannels, nullptr);
+    activeState.assign ((size_t) numChannels, 0.0f);
+    activeChannels.assign ((size_t) numChannels, 0);
+
+    // One ring per channel, plus one for the linked signal
+    rmsWindowLength = std::max (1, (int) std::round (sampleRate * rmsWindowMs / 1000.0));
+    rmsHistory.assign ((size_t) (rmsWindowLength * (numChannels + 1)), 0.0f);
+    rmsSum.assign ((size_t) (numChannels + 1), 0.0f);
+    rmsPosition.assign ((size_t) (numChannels + 1), 0);
+
+    maximumLookahead = getLookaheadSamples (maximumLookaheadMs);
+    lookahead = 0;
+
+    windowCapacity = 1;
+
+    while (windowCapacity < maximumLookahead + 1)
+        windowCapacity *= 2;
+
+    delayBuffer.assign ((size_t) ((maximumLookahead + 1) * numChannels), 0.0f);
+    delayPosition.assign ((size_t) numChannels, 0);
+    windows.assign ((size_t) (numChannels + 1), {});
+    windowValues.assign ((size_t) (windowCapacity * (numChannels + 1)), 0.0f);
+    windowTimes.assign ((size_t) (windowCapacity * (numChannels + 1)), 0);
+
+    inputLoudness.prepare (sampleRate, numChannels);
+    outputLoudness.prepare (sampleRate, numChannels);
+
+    reset();
+}
+
+template <typename SampleType>
+void CompressorKernel<SampleType>::reset() noexcept
+{
+    std::fill (envelopeState.begin(), envelopeState.end(), getDetectorFloor());
+    std::fill (lastGain.begin(), lastGain.end(), -1.0f);
+
+    linkedState = getDetectorFloor();
+    linkedLastGain = -1.0f;
+
+    std::fill (rmsHistory.begin(), rmsHistory.end(), 0.0f);
+    std::fill (rmsSum.begin(), rmsSum.end(), 0.0f);
+    std::fill (rmsPosition.begin(), rmsPosition.end(), 0);
+
+    std::fill (delayBuffer.begin(), delayBuffer.end(), 0.0f);
+    std::fill (delayPosition.begin(), delayPosition.end(), 0);
+    std::fill (windows.begin(), windows.end(), SlidingMaximum {});
+
+    // Measuring starts over with the next block, and its curve applies right away
+    makeUp = MakeUp::curve;
+    hasCurve = false;
+}
+
+template <typename SampleType>
+int CompressorKernel<SampleType>::getLookaheadSamples (float lookaheadMs) const noexcept
+{
+    const auto milliseconds = std::clamp (lookaheadMs, 0.0f, maximumLookaheadMs);
+    return (int) std::round (sampleRate * milliseconds / 1000.0);
+}
+
+template <typename SampleType>
+SampleType CompressorKernel<SampleType>::calculateCoefficient (float timeMs) const noexcept
+{
+    // Same time constant as juce::dsp::BallisticsFilter
+    const double expFactor = -2.0 * 3.141592653589793 * 1000.0 / sampleRate;
+    return timeMs < 1.0e-3f ? (SampleType) 0 : (SampleType) std::exp (expFactor / timeMs);
+}
+
+//==============================================================================
+template <typename SampleType>
+void CompressorKernel<SampleType>::process (SampleType* const* channels, int numChannels, int numSamples,
+                                            const Parameters& parameters) noexcept
+{
+    const GainCurve curve { parameters.threshold, parameters.ratio, parameters.knee };
+    staticMakeUpGainDb = -curve.getGainReduction (0.0f);
+
+    const SampleType curveMakeUpGainDb = staticMakeUpGainDb * parameters.autoGain;
+    makeUpGainDb = curveMakeUpGainDb;
+    numChannels = std::min (numChannels, (int) envelopeState.size());
+
+    if (parameters.makeUp == MakeUp::loudness)
+    {
+        // Start from the curve's make-up gain, so switching over does not jump
+        if (makeUp != MakeUp::loudness)
+        {
+            inputLoudness.reset();
+            outputLoudness.reset();
+            loudnessMakeUpGainDb = (double) makeUpGainDb;
+        }
+
+        makeUpGainDb = (SampleType) loudnessMakeUpGainDb;
+        inputLoudness.process (channels, numChannels, numSamples);
+    }
+
+    makeUp = parameters.makeUp;
+    makeUpGain = Decibels::decibelsToGain (makeUpGainDb);
+    updateCurve (curve, curveMakeUpGainDb, numSamples);
+
+    // While the make-up gain ramps, gain reduction is measured against the lower end of it
+    const SampleType meteredMakeUpGainDb = makeUpMoving ? std::min (curveStart.makeUpGainDb, curveEnd.makeUpGainDb)
+                                                        : makeUpGainDb;
+
+    if (metering)
+    {
+        levels = {};
+        levels.minimumGain = makeUpMoving ? Decibels::decibelsToGain (meteredMakeUpGainDb) : makeUpGain;
+    }
+
+    if (parameters.attack != attackMs)
+    {
+        attackMs = parameters.attack;
+        attackCoefficient = calculateCoefficient (attackMs);
+    }
+
+    if (parameters.release != releaseMs)
+    {
+        releaseMs = parameters.release;
+        releaseCoefficient = calculateCoefficient (releaseMs);
+    }
+
+    controlInterval = std::clamp (parameters.controlInterval, 1, maximumControlInterval);
+    accuracy = parameters.accuracy;
+
+    if (parameters.detector != detector)
+        setDetector (parameters.detector);
+
+    const int newLookahead = std::min (getLookaheadSamples (parameters.lookahead), maximumLookahead);
+
+    if (newLookahead != lookahead)
+        setLookahead (newLookahead);
+
+    // With a single channel every link mode is the same
+    const auto link = numChannels > 1 ? parameters.link : Link::unlinked;
+
+    switch (detector)
+    {
+        case Detector::peak:        processBlocks<Detector::peak>        (channels, numChannels, numSamples, link); break;
+        case Detector::rms:         processBlocks<Detector::rms>         (channels, numChannels, numSamples, link); break;
+        case Detector::logarithmic: processBlocks<Detector::logarithmic> (channels, numChannels, numSamples, link); break;
+    }
+
+    // Keep long release tails from decaying into denormals. A logarithmic
+    // detector settles at minusInfinityDb instead, and 0 dB is a real level to it.
+    if (detector != Detector::logarithmic)
+    {
+        for (auto& state : envelopeState)
+            if (std::abs (state) < 1.0e-8f)
+                state = 0.0f;
+
+        if (std::abs (linkedState) < 1.0e-8f)
+            linkedState = 0.0f;
+    }
+
+    if (makeUp == MakeUp::loudness)
+    {
+        // Measured without the make-up gain, which is constant over the block
+        outputLoudness.process (channels, numChannels, numSamples, (SampleType) 1 / makeUpGain);
+        updateLoudnessMakeUp (parameters, numSamples);
+    }
+
+    if (metering)
+        levels.gainReductionDb = std::min ((SampleType) 0,
+                                           Decibels::gainToDecibels (levels.minimumGain) - meteredMakeUpGainDb);
+}
+
+template <typename SampleType>
+void CompressorKernel<SampleType>::updateCurve (const GainCurve& curve, SampleType curveMakeUpGainDb,
+                                                int numSamples) noexcept
+{
+    const CurveSettings settings { (SampleType) curve.threshold, (SampleType) 1 - (SampleType) 1 / (SampleType) curve.ratio,
+                                   (SampleType) curve.knee, curveMakeUpGainDb };
+
+    // Right after a reset there is nothing to ramp from
+    curveStart = hasCurve ? curveEnd : settings;
+    curveEnd = settings;
+    hasCurve = true;
+
+    const bool wasMoving = curveMoving;
+    curveMoving = curveStart != curveEnd;
+    makeUpMoving = curveMoving && makeUp == MakeUp::curve && curveStart.makeUpGainDb != curveEnd.makeUpGainDb;
+    rampLength = numSamples;
+
+    if (curveMoving)
+    {
+        // The bound moves linearly, so the lower of its two ends holds for the whole block
+        lowerKneeBoundDb = std::min (curveStart.threshold - curveStart.knee / 2, curveEnd.threshold - curveEnd.knee / 2);
+        lowerKneeBoundGain = Decibels::decibelsToGain (lowerKneeBoundDb);
+    }
+    else if (curveTable.update (curve) || wasMoving)
+    {
+        // The table is only rebuilt on the first block after the curve has settled
+        lowerKneeBoundDb = (SampleType) (curve.threshold - curve.knee / 2.0f);
+        lowerKneeBoundGain = Decibels::decibelsToGain (lowerKneeBoundDb);
+    }
+}
+
+template <typename SampleType>
+void CompressorKernel<SampleType>::fillCurveRamps (int offset, int numSamples) noexcept
+{
+    const int interval = controlInterval;
+    const int count = (numSamples + interval - 1) / interval;
+    const SampleType scale = (SampleType) 1 / (SampleType) rampLength;
+    const bool endsRamp = offset + numSamples == rampLength;
+
+    // Each value is the setting at the last sample its gain computation covers
+    const auto fill = [&] (SampleType* ramp, SampleType start, SampleType end)
+    {
+        const SampleType step = (end - start) * scale;
+
+        if (interval == 1)
+            for (int j = 0; j < count; ++j)
+                ramp[j] = start + step * (SampleType) (offset + j + 1);
+        else
+            for (int j = 0; j < count; ++j)
+                ramp[j] = start + step * (SampleType) (offset + std::min ((j + 1) * interval, numSamples));
+
+        if (endsRamp)
+            ramp[count - 1] = end;
+    };
+
+    fill (thresholdRamp.data(), curveStart.threshold, curveEnd.threshold);
+    fill (slopeRamp.data(), curveStart.slope, curveEnd.slope);
+    fill (kneeRamp.data(), curveStart.knee, curveEnd.knee);
+
+    // The loudness make-up gain is moved by its own smoother instead
+    if (makeUp == MakeUp::curve)
+        fill (makeUpRamp.data(), curveStart.makeUpGainDb, curveEnd.makeUpGainDb);
+    else
+        std::fill (makeUpRamp.data(), makeUpRamp.data() + count, makeUpGainDb);
+
+    if (makeUpMoving)
+    {
+        const auto gainAt = [this, scale] (int position)
+        {
+            const auto t = (SampleType) position * scale;
+            return Decibels::decibelsToGain (curveStart.makeUpGainDb + t * (curveEnd.makeUpGainDb - curveStart.makeUpGainDb));
+        };
+
+        interpolateGain (makeUpGainRamp.data(), numSamples, gainAt (offset), gainAt (offset + numSamples));
+    }
+}
+
+template <typename SampleType>
+void CompressorKernel<SampleType>::updateLoudnessMakeUp (const Parameters& parameters, int numSamples) noexcept
+{
+    const auto input = inputLoudness.getLoudness();
+
+    // Hold the gain through pauses, below the absolute gate of BS.1770
+    if (input <= -70.0)
+        return;
+
+    // Never more than the curve's own make-up gain, which brings a full
+    // scale input back to full scale
+    const auto target = std::clamp ((input - outputLoudness.getLoudness()) * parameters.autoGain,
+                                    0.0, std::max (0.0, (double) staticMakeUpGainDb));
+
+    const auto smoothingSamples = sampleRate * parameters.makeUpSmoothing / 1000.0;
+    const auto coefficient = smoothingSamples < 1.0 ? 0.0 : std::exp (-numSamples / smoothingSamples);
+
+    loudnessMakeUpGainDb = target + coefficient * (loudnessMakeUpGainDb - target);
+}
+
+template <typename SampleType>
+void CompressorKernel<SampleType>::setDetector (Detector newDetector) noexcept
+{
+    const bool wasLogarithmic = detector == Detector::logarithmic;
+    const bool isLogarithmic  = newDetector == Detector::logarithmic;
+
+    // Carry the envelopes over, so switching does not pump
+    if (wasLogarithmic != isLogarithmic)
+    {
+        const auto convert = [isLogarithmic] (SampleType& state)
+        {
+            state = isLogarithmic ? Decibels::gainToDecibels (state) : Decibels::decibelsToGain (state);
+        };
+
+        std::for_each (envelopeState.begin(), envelopeState.end(), convert);
+        convert (linkedState);
+    }
+
+    std::fill (rmsHistory.begin(), rmsHistory.end(), 0.0f);
+    std::fill (rmsSum.begin(), rmsSum.end(), 0.0f);
+    std::fill (rmsPosition.begin(), rmsPosition.end(), 0);
+
+    detector = newDetector;
+}
+
+template <typename SampleType>
+void CompressorKernel<SampleType>::setLookahead (int newLookahead) noexcept
+{
+    // Nothing has been written while the lookahead was off, so start from silence
+    if (lookahead == 0)
+    {
+        std::fill (delayBuffer.begin(), delayBuffer.end(), 0.0f);
+        std::fill (delayPosition.begin(), delayPosition.end(), 0);
+        std::fill (windows.begin(), windows.end(), SlidingMaximum {});
+    }
+
+    lookahead = newLookahead;
+}
+
+template <typename SampleType>
+SampleType CompressorKernel<SampleType>::getDetectorFloor() const noexcept
+{
+    return detector == Detector::logarithmic ? (SampleType) Decibels::minusInfinityDb : (SampleType) 0;
+}
+
+template <typename SampleType>
+template <Detector type>
+void CompressorKernel<SampleType>::processBlocks (SampleType* const* channels, int numChannels, int numSamples,
+                                                  Link link) noexcept
+{
+    for (int offset = 0; offset < numSamples; offset += maximumBlockSize)
+    {
+        const int n = std::min (maximumBlockSize, numSamples - offset);
+
+        if (curveMoving)
+            fillCurveRamps (offset, n);
+
+        if (link != Link::unlinked)
+            processLinked<type> (channels, numChannels, offset, n, link);
+        else
+            processUnlinked<type> (channels, numChannels, offset, n);
+    }
+}
+
+template <typename SampleType>
+template <Detector type>
+void CompressorKernel<SampleType>::processUnlinked (SampleType* const* channels, int numChannels,
+                                                    int offset, int numSamples) noexcept
+{
+    int numActive = 0;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        SampleType* samples = channels[channel] + offset;
+        SampleType* envelope = envelopeBuffer.data() + channel * maximumBlockSize;
+        const SampleType* input = samples;
+
+        // The peak detector reads the samples directly, unless they are about to be delayed
+        const bool readsSamples = type == Detector::peak && lookahead == 0;
+
+        if (! readsSamples)
+        {
+            prepareDetectorInput<type> (samples, envelope, numSamples, channel);
+
+            if (lookahead > 0)
+            {
+                applyLookahead (envelope, numSamples, channel);
+                delay (samples, numSamples, channel);
+            }
+
+            input = envelope;
+        }
+
+        SampleType peak = 0, squares = 0;
+        SampleType* meteredSquares = readsSamples && metering ? &squares : nullptr;
+
+        if (advanceIfIdle<type> (input, numSamples, envelopeState[(size_t) channel], peak, meteredSquares))
+        {
+            applyMakeUpGain (samples, numSamples, readsSamples ? peak : (SampleType) -1, squares);
+            lastGain[(size_t) channel] = makeUpGain;
+            continue;
+        }
+
+        activeChannels[(size_t) numActive] = channel;
+        activeSource[(size_t) numActive]   = samples;
+        activeInput[(size_t) numActive]    = input;
+        activeEnvelope[(size_t) numActive] = envelope;
+        activeState[(size_t) numActive]    = envelopeState[(size_t) channel];
+        ++numActive;
+    }
+
+    followLevels<type == Detector::peak> (activeInput.data(), activeEnvelope.data(), numActive, numSamples,
+                                          activeState.data(), attackCoefficient, releaseCoefficient,
+                                          interleaveBuffer.data());
+
+    SampleType* gain = gainBuffer.data();
+
+    for (int i = 0; i < numActive; ++i)
+    {
+        const auto channel = (size_t) activeChannels[(size_t) i];
+        envelopeState[channel] = activeState[(size_t) i];
+
+        computeGain<type> (activeEnvelope[(size_t) i], gain, numSamples, lastGain[channel]);
+
+        if (metering)
+            applyGain (activeSource[(size_t) i], gain, numSamples, levels);
+        else
+            applyGain (activeSource[(size_t) i], gain, numSamples);
+    }
+}
+
+template <typename SampleType>
+template <Detector type>
+void CompressorKernel<SampleType>::processLinked (SampleType* const* channels, int numChannels, int offset, int numSamples,
+                                                  Link link) noexcept
+{
+    for (int channel = 0; channel < numChannels; ++channel)
+        activeSource[(size_t) channel] = channels[channel] + offset;
+
+    SampleType* input = linkBuffer.data();
+    linkChannels (activeSource.data(), numChannels, input, numSamples, link);
+
+    const int slot = (int) envelopeState.size();
+
+    // The linked signal is rectified already, so it can be prepared in place
+    if constexpr (type != Detector::peak)
+        prepareDetectorInput<type> (input, input, numSamples, slot);
+
+    if (lookahead > 0)
+    {
+        applyLookahead (input, numSamples, slot);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            delay (activeSource[(size_t) channel], numSamples, channel);
+    }
+
+    SampleType peak = 0;
+
+    if (advanceIfIdle<type> (input, numSamples, linkedState, peak, nullptr))
+    {
+        // The linked signal says nothing about the channel levels, so these are read once
+        for (int channel = 0; channel < numChannels; ++channel)
+            applyMakeUpGain (activeSource[(size_t) channel], numSamples, -1, 0);
+
+        linkedLastGain = makeUpGain;
+        return;
+    }
+
+    SampleType* envelope = envelopeBuffer.data();
+    SampleType* gain = gainBuffer.data();
+
+    linkedState = followLevel<type == Detector::peak, true> (input, envelope, numSamples, linkedState,
+                                                             attackCoefficient, releaseCoefficient);
+    computeGain<type> (envelope, gain, numSamples, linkedLastGain);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        if (metering)
+            applyGain (activeSource[(size_t) channel], gain, numSamples, levels);
+        else
+            applyGain (activeSource[(size_t) channel], gain, numSamples);
+    }
+}
+
+template <typename SampleType>
+void CompressorKernel<SampleType>::applyMakeUpGain (SampleType* samples, int numSamples,
+                                                    SampleType peak, SampleType squares) noexcept
+{
+    if (makeUpMoving)
+    {
+        if (metering)
+            applyGain (samples, makeUpGainRamp.data(), numSamples, levels);
+        else
+            applyGain (samples, makeUpGainRamp.data(), numSamples);
+    }
+    else if (metering && peak < 0)
+    {
+        applyGain (samples, makeUpGain, numSamples, levels);
+    }
+    else
+    {
+        if (makeUpGain != 1.0f)
+            applyGain (samples, makeUpGain, numSamples);
+
+        // The peak check has read the block already, the output follows from it
+        if (metering)
+            levels.add (peak, squares, peak * makeUpGain, squares * makeUpGain * makeUpGain,
+                        makeUpGain, numSamples);
+    }
+}
+
+template <typename SampleType>
+template <Detector type>
+void CompressorKernel<SampleType>::prepareDetectorInput (const SampleType* source, SampleType* dest,
+                                                         int numSamples, int slot) noexcept
+{
+    if constexpr (type == Detector::rms)
+    {
+        computeWindowedRms (source, dest, numSamples, slot);
+    }
+    else
+    {
+        using Vector = SIMDVector<SampleType>;
+        int i = 0;
+
+        for (; i <= numSamples - Vector::size; i += Vector::size)
+            Vector::abs (Vector::load (source + i)).store (dest + i);
+
+        for (; i < numSamples; ++i)
+            dest[i] = std::abs (source[i]);
+
+        if constexpr (type == Detector::logarithmic)
+            Decibels::gainToDecibels (dest, dest, numSamples, accuracy);
+    }
+}
+
+template <typename SampleType>
+void CompressorKernel<SampleType>::computeWindowedRms (const SampleType* source, SampleType* dest,
+                                                       int numSamples, int slot) noexcept
+{
+    using Vector = SIMDVector<SampleType>;
+
+    const int length = rmsWindowLength;
+    const SampleType scale = (SampleType) 1 / (SampleType) length;
+
+    SampleType* history = rmsHistory.data() + slot * length;
+    SampleType& sum = rmsSum[(size_t) slot];
+    int& position = rmsPosition[(size_t) slot];
+
+    // Mean squares, in runs up to the end of the ring so the inner loop has no wrap check
+    for (int i = 0; i < numSamples;)
+    {
+        const int run = std::min (numSamples - i, length - position);
+        SampleType* squares = history + position;
+
+        for (int j = 0; j < run; ++j)
+        {
+            const SampleType square = source[i + j] * source[i + j];
+            sum += square - squares[j];
+            squares[j] = square;
+            dest[i + j] = sum * scale;
+        }
+
+        i += run;
+        position += run;
+
+        // Start every lap from an exact sum, so rounding errors cannot build up
+        if (position == length)
+        {
+            position = 0;
+            sum = 0;
+
+            for (int j = 0; j < length; ++j)
+                sum += history[j];
+        }
+    }
+
+    const auto zero = Vector::broadcast (0.0f);
+    int i = 0;
+
+    for (; i <= numSamples - Vector::size; i += Vector::size)
+        Vector::sqrt (Vector::max (Vector::load (dest + i), zero)).store (dest + i);
+
+    for (; i < numSamples; ++i)
+        dest[i] = std::sqrt (std::max ((SampleType) 0, dest[i]));
+}
+
+template <typename SampleType>
+void CompressorKernel<SampleType>::applyLookahead (SampleType* envelope, int numSamples, int slot) noexcept
+{
+    auto& window = windows[(size_t) slot];
+    SampleType* values = windowValues.data() + slot * windowCapacity;
+    uint32_t* times = windowTimes.data() + slot * windowCapacity;
+
+    const int mask = windowCapacity - 1;
+    const auto length = (uint32_t) lookahead + 1;
+
+    // Values decrease from the front of the deque to the back, so the front is the maximum
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const SampleType level = envelope[i];
+
+        while (window.size > 0 && values[(window.head + window.size - 1) & mask] <= level)
+            --window.size;
+
+        const int back = (window.head + window.size) & mask;
+        values[back] = level;
+        times[back] = window.time;
+        ++window.size;
+
+        // Unsigned differences stay right when the time wraps around
+        while (window.time - times[window.head] >= length)
+        {
+            window.head = (window.head + 1) & mask;
+            --window.size;
+        }
+
+        envelope[i] = values[window.head];
+        ++window.time;
+    }
+}
+
+template <typename SampleType>
+void CompressorKernel<SampleType>::delay (SampleType* samples, int numSamples, int channel) noexcept
+{
+    const int size = maximumLookahead + 1;
+    SampleType* line = delayBuffer.data() + channel * size;
+
+    int& writePosition = delayPosition[(size_t) channel];
+    int readPosition = writePosition >= lookahead ? writePosition - lookahead
+                                                  : writePosition - lookahead + size;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        line[writePosition] = samples[i];
+        samples[i] = line[readPosition];
+
+        if (++writePosition == size)
+            writePosition = 0;
+
+        if (++readPosition == size)
+            readPosition = 0;
+    }
+}
+
+template <typename SampleType>
+template <Detector type>
+bool CompressorKernel<SampleType>::advanceIfIdle (const SampleType* source, int numSamples, SampleType& state,
+                                                  SampleType& peak, SampleType* squares) const noexcept
+{
+    constexpr bool logarithmic = type == Detector::logarithmic;
+    const SampleType bound = logarithmic ? lowerKneeBoundDb : lowerKneeBoundGain;
+
+    if (state >= bound)
+        return false;
+
+    if constexpr (logarithmic)
+        peak = getMaximum (source, numSamples);
+    else
+        peak = getPeak (source, numSamples, squares);
+
+    if (peak >= bound)
+        return false;
+
+    const SampleType floor = logarithmic ? (SampleType) Decibels::minusInfinityDb : (SampleType) 0;
+
+    if (peak == floor)
+        state = floor + (state - floor) * std::pow (releaseCoefficient, (SampleType) numSamples);
+    else
+        state = followLevel<type == Detector::peak, false> (source, (SampleType*) nullptr, numSamples, state,
+                                                            attackCoefficient, releaseCoefficient);
+
+    return true;
+}
+
+template <typename SampleType>
+template <Detector type>
+void CompressorKernel<SampleType>::computeGain (SampleType* envelope, SampleType* gain, int numSamples,
+                                                SampleType& previousGain) noexcept
+{
+    if (controlInterval > 1)
+    {
+        computeControlRateGain<type> (envelope, gain, numSamples, previousGain);
+        return;
+    }
+
+    if constexpr (type != Detector::logarithmic)
+        Decibels::gainToDecibels (envelope, envelope, numSamples, accuracy);
+
+    if (curveMoving)
+        computeGain (envelope, gain, numSamples, thresholdRamp.data(), slopeRamp.data(), kneeRamp.data(), makeUpRamp.data());
+    else
+        computeGain (envelope, gain, numSamples, curveTable, makeUpGainDb);
+
+    Decibels::decibelsToGain (gain, gain, numSamples, accuracy);
+    previousGain = gain[numSamples - 1];
+}
+
+template <typename SampleType>
+template <Detector type>
+void CompressorKernel<SampleType>::computeControlRateGain (const SampleType* envelope, SampleType* gain, int numSamples,
+                                                           SampleType& previousGain) noexcept
+{
+    const int interval = controlInterval;
+    const int numPoints = (numSamples + interval - 1) / interval;
+
+    SampleType* control = controlBuffer.data();
+
+    // One control point at the end of every segment, the last one may be shorter
+    for (int k = 0; k < numPoints; ++k)
+        control[k] = envelope[std::min ((k + 1) * interval, numSamples) - 1];
+
+    if constexpr (type != Detector::logarithmic)
+        Decibels::gainToDecibels (control, control, numPoints, accuracy);
+
+    // The ramps hold one value per control point here
+    if (curveMoving)
+        computeGain (control, control, numPoints, thresholdRamp.data(), slopeRamp.data(), kneeRamp.data(), makeUpRamp.data());
+    else
+        computeGain (control, control, numPoints, curveTable, makeUpGainDb);
+
+    Decibels::decibelsToGain (control, control, numPoints, accuracy);
+
+    // Nothing to ramp from right after a reset
+    if (previousGain < 0.0f)
+        previousGain = control[0];
+
+    for (int k = 0; k < numPoints; ++k)
+    {
+        const int start = k * interval;
+        interpolateGain (gain + start, std::min (interval, numSamples - start), previousGain, control[k]);
+        previousGain = control[k];
+    }
+}
+
+//==============================================================================
+template <typename SampleType>
+SampleType CompressorKernel<SampleType>::detect (const SampleType* source, SampleType* envelope, int numSamples,
+                                                 SampleType state, SampleType attackCoefficient,
+                                                 SampleType releaseCoefficient) noexcept
+{
+    return followLevel<true, true> (source, envelope, numSamples, state, attackCoefficient, releaseCoefficient);
+}
+
+template <typename SampleType>
+SampleType CompressorKernel<SampleType>::advance (const SampleType* source, int numSamples,
+                                                  SampleType state, SampleType attackCoefficient,
+                                                  SampleType releaseCoefficient) noexcept
+{
+    return followLevel<true, false> (source, (SampleType*) nullptr, numSamples, state, attackCoefficient, releaseCoefficient);
+}
+
+template <typename SampleType>
+void CompressorKernel<SampleType>::detect (const SampleType* const* source, SampleType* const* envelope,
+                                           int numChannels, int numSamples, SampleType* states, SampleType attackCoefficient, SampleType releaseCoefficient,
+                                           SampleType* scratch) noexcept
+{
+    followLevels<true> (source, envelope, numChannels, numSamples, states,
+                        attackCoefficient, releaseCoefficient, scratch);
+}
+
+namespace
+{
+    template <typename Vector, typename SampleType>
+    Vector linkFrame (const SampleType* const* source, int numChannels, int index, Link link) noexcept
+    {
+        if (link == Link::rms)
+        {
+            auto sum = Vector::broadcast (0.0f);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                const auto x = Vector::load (source[channel] + index);
+                sum = sum + x * x;
+            }
+
+            return Vector::sqrt (sum * Vector::broadcast ((SampleType) 1 / (SampleType) numChannels));
+        }
+
+        auto peak = Vector::abs (Vector::load (source[0] + index));
+
+        for (int channel = 1; channel < numChannels; ++channel)
+            peak = Vector::max (peak, Vector::abs (Vector::load (source[channel] + index)));
+
+        return peak;
+    }
+}
+
+template <typename SampleType>
+void CompressorKernel<SampleType>::linkChannels (const SampleType* const* source, int numChannels, SampleType* dest,
+                                                 int numSamples, Link link) noexcept
+{
+    using Vector = SIMDVector<SampleType>;
+
+    int i = 0;
+
+    for (; i <= numSamples - Vector::size; i += Vector::size)
+        linkFrame<Vector> (source, numChannels, i, link).store (dest + i);
+
+    for (; i < numSamples; ++i)
+        linkFrame<ScalarVector<SampleType>> (source, numChannels, i, link).store (dest + i);
+}
+
+template <typename SampleType>
+SampleType CompressorKernel<SampleType>::getPeak (const SampleType* samples, int numSamples, SampleType* squares) noexcept
+{
+    using Vector = SIMDVector<SampleType>;
+
+    SampleType peak = 0.0f;
+    int i = 0;
+
+    if (squares != nullptr)
+    {
+        SampleType sum = 0;
+
+        if (i <= numSamples - Vector::size)
+        {
+            auto peaks = Vector::broadcast (0.0f);
+            auto sums  = Vector::broadcast (0.0f);
+
+            for (; i <= numSamples - Vector::size; i += Vector::size)
+            {
+                const auto x = Vector::load (samples + i);
+                peaks = Vector::max (peaks, Vector::abs (x));
+                sums = sums + x * x;
+            }
+
+            peak = horizontalMax<SampleType> (peaks);
+            sum = horizontalSum<SampleType> (sums);
+        }
+
+        for (; i < numSamples; ++i)
+        {
+            peak = std::max (peak, std::abs (samples[i]));
+            sum += samples[i] * samples[i];
+        }
+
+        *squares += sum;
+        return peak;
+    }
+
+    if (i <= numSamples - Vector::size)
+    {
+        auto peaks = Vector::broadcast (0.0f);
+
+        for (; i <= numSamples - Vector::size; i += Vector::size)
+            peaks = Vector::max (peaks, Vector::abs (Vector::load (samples + i)));
+
+        peak = horizontalMax<SampleType> (peaks);
+    }
+
+    for (; i < numSamples; ++i)
+        peak = std::max (peak, std::abs (samples[i]));
+
+    return peak;
+}
+
+template <typename SampleType>
+void CompressorKernel<SampleType>::computeGain (const SampleType* envelopeDb, SampleType* gainDb, int numSamples,
+                                                const GainCurveTable<SampleType>& curve, SampleType makeUpGainDb) noexcept
+{
+    using Vector = SIMDVector<SampleType>;
+
+    const auto makeUpGain = Vector::broadcast (makeUpGainDb);
+    int i = 0;
+
+    for (; i <= numSamples - Vector::size; i += Vector::size)
+        (curve.getGainReduction (Vector::load (envelopeDb + i)) + makeUpGain).store (gainDb + i);
+
+    // The tail goes through the same lane arithmetic, one sample at a time
+    for (; i < numSamples; ++i)
+        gainDb[i] = curve.getGainReduction (envelopeDb[i]) + makeUpGainDb;
+}
+
+namespace
+{
+    template <typename Vector, typename SampleType>
+    Vector rampedGain (const SampleType* envelopeDb, const SampleType* threshold, const SampleType* slope,
+                       const SampleType* knee, const SampleType* makeUpGainDb, int index) noexcept
+    {
+        const auto gainReduction = GainCurve::getGainReductionForSlope (Vector::load (envelopeDb + index),
+                                                                       Vector::load (threshold + index),
+                                                                       Vector::load (slope + index),
+                                                                       Vector::load (knee + index));
+        return gainReduction + Vector::load (makeUpGainDb + index);
+    }
+}
+
+template <typename SampleType>
+void CompressorKernel<SampleType>::computeGain (const SampleType* envelopeDb, SampleType* gainDb, int numSamples,
+                                                const SampleType* threshold, const SampleType* slope,
+                                                const SampleType* knee, const SampleType* makeUpGainDb) noexcept
+{
+    using Vector = SIMDVector<SampleType>;
+
+    int i = 0;
+
+    for (; i <= numSamples - Vector::size; i += Vector::size)
+        rampedGain<Vector> (envelopeDb, threshold, slope, knee, makeUpGainDb, i).store (gainDb + i);
+
+    for (; i < numSamples; ++i)
+        rampedGain<ScalarVector<SampleType>> (envelopeDb, threshold, slope, knee, makeUpGainDb, i).store (gainDb + i);
+}
+
+template <typename SampleType>
+void CompressorKernel<SampleType>::interpolateGain (SampleType* gain, int numSamples,
+                                                    SampleType start, SampleType end) noexcept
+{
+    using Vector = SIMDVector<SampleType>;
+
+    const SampleType step = (end - start) / (SampleType) numSamples;
+    int i = 0;
+
+    if (i <= numSamples - Vector::size)
+    {
+        SampleType offsets[Vector::size];
+
+        for (int lane = 0; lane < Vector::size; ++lane)
+            offsets[lane] = (SampleType) (lane + 1);
+
+        const auto first = Vector::load (offsets);
+
+        for (; i <= numSamples - Vector::size; i += Vector::size)
+        {
+            const auto position = first + Vector::broadcast ((SampleType) i);
+            (Vector::broadcast (start) + position * Vector::broadcast (step)).store (gain + i);
+        }
+    }
+
+    for (; i < numSamples; ++i)
+        gain[i] = start + (SampleType) (i + 1) * step;
+
+    gain[numSamples - 1] = end;
+}
+
+template <typename SampleType>
+void CompressorKernel<SampleType>::applyGain (SampleType* samples, const SampleType* gain, int numSamples) noexcept
+{
+    using Vector = SIMDVector<SampleType>;
+
+    int i = 0;
+
+    for (; i <= numSamples - Vector::size; i += Vector::size)
+        (Vector::load (samples + i) * Vector::load (gain + i)).store (samples + i);
+
+    for (; i < numSamples; ++i)
+        samples[i] *= gain[i];
+}
+
+template <typename SampleType>
+void CompressorKernel<SampleType>::applyGain (SampleType* samples, SampleType gain, int numSamples) noexcept
+{
+    using Vector = SIMDVector<SampleType>;
+
+    const auto g = Vector::broadcast (gain);
+    int i = 0;
+
+    for (; i <= numSamples - Vector::size; i += Vector::size)
+        (Vector::load (samples + i) * g).store (samples + i);
+
+    for (; i < numSamples; ++i)
+        samples[i] *= gain;
+}
+
+template <typename SampleType>
+void CompressorKernel<SampleType>::applyGain (SampleType* samples, const SampleType* gain, int numSamples,
+                                              Levels& levels) noexcept
+{
+    using Vector = SIMDVector<SampleType>;
+
+    SampleType inPeak = 0, outPeak = 0, inSquares = 0, outSquares = 0, lowestGain = levels.minimumGain;
+    int i = 0;
+
+    if (i <= numSamples - Vector::size)
+    {
+        auto inPeaks = Vector::broadcast (0.0f), outPeaks = Vector::broadcast (0.0f);
+        auto inSums  = Vector::broadcast (0.0f), outSums  = Vector::broadcast (0.0f);
+        auto lowest  = Vector::broadcast (lowestGain);
+
+        for (; i <= numSamples - Vector::size; i += Vector::size)
+        {
+            const auto x = Vector::load (samples + i);
+            const auto g = Vector::load (gain + i);
+            const auto y = x * g;
+
+            inPeaks  = Vector::max (inPeaks, Vector::abs (x));
+            outPeaks = Vector::max (outPeaks, Vector::abs (y));
+            inSums   = inSums + x * x;
+            outSums  = outSums + y * y;
+            lowest   = Vector::min (lowest, g);
+
+            y.store (samples + i);
+        }
+
+        inPeak     = horizontalMax<SampleType> (inPeaks);
+        outPeak    = horizontalMax<SampleType> (outPeaks);
+        inSquares  = horizontalSum<SampleType> (inSums);
+        outSquares = horizontalSum<SampleType> (outSums);
+        lowestGain = horizontalMin<SampleType> (lowest);
+    }
+
+    for (; i < numSamples; ++i)
+    {
+        const auto x = samples[i];
+        const auto y = x * gain[i];
+
+        inPeak     = std::max (inPeak, std::abs (x));
+        outPeak    = std::max (outPeak, std::abs (y));
+        inSquares  += x * x;
+        outSquares += y * y;
+        lowestGain = std::min (lowestGain, gain[i]);
+
+        samples[i] = y;
+    }
+
+    levels.add (inPeak, inSquares, outPeak, outSquares, lowestGain, numSamples);
+}
+
+template <typename SampleType>
+void CompressorKernel<SampleType>::applyGain (SampleType* samples, SampleType gain, int numSamples,
+                                              Levels& levels) noexcept
+{
+    SampleType squares = 0;
+    SampleType peak;
+
+    if (gain == 1.0f)
+    {
+        peak = getPeak (samples, numSamples, &squares);
+    }
+    else
+    {
+        using Vector = SIMDVector<SampleType>;
+
+        const auto g = Vector::broadcast (gain);
+        peak = 0;
+        int i = 0;
+
+        if (i <= numSamples - Vector::size)
+        {
+            auto peaks = Vector::broadcast (0.0f);
+            auto sums  = Vector::broadcast (0.0f);
+
+            for (; i <= numSamples - Vector::size; i += Vector::size)
+            {
+                const auto x = Vector::load (samples + i);
+                peaks = Vector::max (peaks, Vector::abs (x));
+                sums = sums + x * x;
+                (x * g).store (samples + i);
+            }
+
+            peak = horizontalMax<SampleType> (peaks);
+            squares = horizontalSum<SampleType> (sums);
+        }
+
+        for (; i < numSamples; ++i)
+        {
+            peak = std::max (peak, std::abs (samples[i]));
+            squares += samples[i] * samples[i];
+            samples[i] *= gain;
+        }
+    }
+
+    const auto magnitude = std::abs (gain);
+    levels.add (peak, squares, peak * magnitude, squares * gain * gain, gain, numSamples);
+}
+
+template class CompressorKernel<float>;
+template class CompressorKernel<double>;
+
+} // namespace VocalDSP
@@ -0,0 +1,183 @@
+/*
+  ==============================================================================
+
+    GainCurve.h
+
+    The static soft-knee compression curve, as derived in
+    Resources/Dynamic Range Compression.ipynb, and a cached lookup table of
+    it for the audio thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+
+#include "SIMD.h"
+
+namespace VocalDSP
+{
+
+struct GainCurve
+{
+    float threshold = -18.0f;   // dBFS
+    float ratio     = 4.0f;     // n:1
+    float knee      = 18.0f;    // dB
+
+    /** Returns the gain reduction in dB (<= 0) for an envelope level in dB. */
+    float getGainReduction (float envelope) const noexcept
+    {
+        float lowerKneeBound = threshold - (knee / 2.0f);
+        float upperKneeBound = threshold + (knee / 2.0f);
+
+        float gainReduction = 1.0f - (1.0f / ratio);
+
+        if (envelope < lowerKneeBound)
+        {
+            return 0.0f;
+        }
+        else if (envelope < upperKneeBound)
+        {
+            gainReduction *= ((envelope - lowerKneeBound) / knee) / 2.0f;
+            return gainReduction * (lowerKneeBound - envelope);
+        }
+        else
+        {
+            return gainReduction * (threshold - envelope);
+        }
+    }
+
+    /** Branch-free version of getGainReduction(), evaluating the same
+        arithmetic for every lane of a SIMDVector.
+    */
+    template <typename Vector>
+    Vector getGainReduction (Vector envelope) const noexcept
+    {
+        return getGainReduction (envelope, Vector::broadcast (threshold), Vector::broadcast (ratio), Vector::broadcast (knee));
+    }
+
+    /** The same curve with separate parameters per lane. */
+    template <typename Vector>
+    static Vector getGainReduction (Vector envelope, Vector threshold, Vector ratio, Vector knee) noexcept
+    {
+        const auto slope = Vector::broadcast (1.0f) - (Vector::broadcast (1.0f) / ratio);
+        return getGainReductionForSlope (envelope, threshold, slope, knee);
+    }
+
+    /** The same curve with the slope above the knee, 1 - 1 / ratio, in place of the ratio. */
+    template <typename Vector>
+    static Vector getGainReductionForSlope (Vector envelope, Vector threshold, Vector slope, Vector knee) noexcept
+    {
+        const auto two = Vector::broadcast (2.0f);
+
+        const auto lowerKneeBound = threshold - (knee / two);
+        const auto upperKneeBound = threshold + (knee / two);
+
+        auto inKnee = slope * (((envelope - lowerKneeBound) / knee) / two);
+        inKnee = inKnee * (lowerKneeBound - envelope);
+
+        auto aboveKnee = slope * (threshold - envelope);
+
+        auto result = Vector::select (Vector::lessThan (envelope, upperKneeBound), inKnee, aboveKnee);
+        return Vector::select (Vector::lessThan (envelope, lowerKneeBound), Vector::broadcast (0.0f), result);
+    }
+
+    bool operator== (const GainCurve& other) const noexcept
+    {
+        return threshold == other.threshold && ratio == other.ratio && knee == other.knee;
+    }
+
+    bool operator!= (const GainCurve& other) const noexcept   { return ! operator== (other); }
+};
+
+//==============================================================================
+/**
+    A dense table of a GainCurve, indexed by envelope level in dB and
+    linearly interpolated, so the per-sample curve is a fetch rather than
+    a branchy evaluation with a division.
+
+    The table spans -100 dB (the detector floor) to +50 dB, above the highest
+    possible upper knee bound, so levels outside it are extrapolated exactly
+    along the flat or linear part of the curve. With 8 points per dB the
+    interpolation error inside the knee is below 0.005 dB for knees of 0.5 dB or
+    more, and at most 0.03 dB around the corner of a hard knee.
+
+    The table is held in the sample type of the engine using it.
+*/
+template <typename SampleType>
+class GainCurveTable
+{
+public:
+    static constexpr float minimumDb = -100.0f;
+    static constexpr float maximumDb = 50.0f;
+    static constexpr int pointsPerDb = 8;
+    static constexpr int size = (int) (maximumDb - minimumDb) * pointsPerDb + 1;
+
+    /** Rebuilds the table if the curve differs from the one it was built for.
+        Returns true if it was rebuilt.
+    */
+    bool update (const GainCurve& newCurve) noexcept
+    {
+        if (isValid && newCurve == curve)
+            return false;
+
+        using Vector = SIMDVector<SampleType>;
+
+        curve = newCurve;
+        isValid = true;
+
+        int i = 0;
+
+        for (; i <= size - Vector::size; i += Vector::size)
+        {
+            SampleType envelope[Vector::size];
+
+            for (int lane = 0; lane < Vector::size; ++lane)
+                envelope[lane] = getLevelAtIndex (i + lane);
+
+            curve.getGainReduction (Vector::load (envelope)).store (table.data() + i);
+        }
+
+        for (; i < size; ++i)
+            table[(size_t) i] = curve.getGainReduction (ScalarVector<SampleType>::broadcast (getLevelAtIndex (i))).value;
+
+        return true;
+    }
+
+    const GainCurve& getCurve() const noexcept      { return curve; }
+
+    /** Returns the interpolated gain reduction in dB for an envelope level in dB. */
+    SampleType getGainReduction (SampleType envelope) const noexcept
+    {
+        return getGainReduction (ScalarVector<SampleType>::broadcast (envelope)).value;
+    }
+
+    /** SIMD version of getGainReduction(), with the same arithmetic per lane. */
+    template <typename Vector>
+    Vector getGainReduction (Vector envelope) const noexcept
+    {
+        const auto position = (envelope - Vector::broadcast (minimumDb)) * Vector::broadcast ((SampleType) pointsPerDb);
+
+        auto index = Vector::truncate (position);
+        index = Vector::max (index, Vector::broadcast ((SampleType) 0));
+        index = Vector::min (index, Vector::broadcast ((SampleType) (size - 2)));
+
+        const auto fraction = position - index;
+        const auto a = Vector::gather (table.data(), index);
+        const auto b = Vector::gather (table.data() + 1, index);
+        return a + fraction * (b - a);
+    }
+
+private:
+    static SampleType getLevelAtIndex (int index) noexcept
+    {
+        return (SampleType) minimumDb + (SampleType) index / (SampleType) pointsPerDb;
+    }
+
+    GainCurve curve;
+    bool isValid = false;
+    std::array<SampleType, (size_t) size> table {};
+};
+
+} // namespace VocalDSP
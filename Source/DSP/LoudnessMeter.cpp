@@ -0,0 +1,203 @@
+/*
+  ==============================================================================
+
+    LoudnessMeter.cpp
+
+  ==============================================================================
+*/
+
+#include "LoudnessMeter.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace VocalDSP
+{
+
+//==============================================================================
+template <typename SampleType>
+void LoudnessMeter<SampleType>::prepare (double sampleRate, int numChannels)
+{
+    constexpr double pi = 3.141592653589793;
+
+    // The 48 kHz coefficients of BS.1770 as analog prototypes, so that any
+    // rate gets the same response, like libebur128 does
+    {
+        const double frequency = 1681.974450955533;
+        const double gainDb = 3.999843853973347;
+        const double q = 0.7071752369554196;
+
+        const double k = std::tan (pi * frequency / sampleRate);
+        const double vh = std::pow (10.0, gainDb / 20.0);
+        const double vb = std::pow (vh, 0.4996667741545416);
+        const double a0 = 1.0 + k / q + k * k;
+
+        shelf.b0 = (vh + vb * k / q + k * k) / a0;
+        shelf.b1 = 2.0 * (k * k - vh) / a0;
+        shelf.b2 = (vh - vb * k / q + k * k) / a0;
+        shelf.a1 = 2.0 * (k * k - 1.0) / a0;
+        shelf.a2 = (1.0 - k / q + k * k) / a0;
+    }
+
+    {
+        const double frequency = 38.13547087602444;
+        const double q = 0.5003270373238773;
+
+        const double k = std::tan (pi * frequency / sampleRate);
+        const double a0 = 1.0 + k / q + k * k;
+
+        highPass.b0 = 1.0;
+        highPass.b1 = -2.0;
+        highPass.b2 = 1.0;
+        highPass.a1 = 2.0 * (k * k - 1.0) / a0;
+        highPass.a2 = (1.0 - k / q + k * k) / a0;
+    }
+
+    using Vector = SIMDVector<double>;
+
+    numChannelsPrepared = std::max (0, numChannels);
+    const int numGroups = (numChannelsPrepared + Vector::size - 1) / Vector::size;
+    states.assign ((size_t) (4 * Vector::size * numGroups), 0.0);
+
+    segmentLength = std::max (1, (int) std::round (sampleRate * segmentSeconds));
+    segments.assign ((size_t) std::round (windowSeconds / segmentSeconds), 0.0);
+
+    reset();
+}
+
+template <typename SampleType>
+void LoudnessMeter<SampleType>::reset() noexcept
+{
+    std::fill (states.begin(), states.end(), 0.0);
+    std::fill (segments.begin(), segments.end(), 0.0);
+
+    segmentPosition = 0;
+    segmentSum = 0.0;
+    nextSegment = 0;
+    numSegments = 0;
+    windowSum = 0.0;
+}
+
+//==============================================================================
+template <typename SampleType>
+void LoudnessMeter<SampleType>::process (const SampleType* const* channels, int numChannels, int numSamples,
+                                         SampleType gain) noexcept
+{
+    constexpr int lanes = SIMDVector<double>::size;
+
+    numChannels = std::min (numChannels, numChannelsPrepared);
+
+    for (int offset = 0; offset < numSamples;)
+    {
+        // Up to the end of the current segment
+        const int n = std::min (numSamples - offset, segmentLength - segmentPosition);
+
+        for (int first = 0; first < numChannels; first += lanes)
+            segmentSum += weigh (channels + first, std::min (lanes, numChannels - first), offset, n, gain,
+                                 states.data() + 4 * first);
+
+        offset += n;
+        segmentPosition += n;
+
+        if (segmentPosition == segmentLength)
+        {
+            auto& oldest = segments[(size_t) nextSegment];
+            windowSum = std::max (0.0, windowSum + segmentSum - oldest);
+            oldest = segmentSum;
+
+            nextSegment = (nextSegment + 1) % (int) segments.size();
+            numSegments = std::min (numSegments + 1, (int) segments.size());
+
+            segmentPosition = 0;
+            segmentSum = 0.0;
+        }
+    }
+
+    // Keep the filters from decaying into denormals through silence
+    for (auto& state : states)
+        if (std::abs (state) < 1.0e-15)
+            state = 0.0;
+}
+
+template <typename SampleType>
+double LoudnessMeter<SampleType>::getLoudness() const noexcept
+{
+    if (numSegments == 0)
+        return silenceLufs;
+
+    const double meanSquare = windowSum / ((double) numSegments * segmentLength);
+
+    return meanSquare > 0.0 ? std::max (silenceLufs, -0.691 + 10.0 * std::log10 (meanSquare))
+                            : silenceLufs;
+}
+
+template <typename SampleType>
+double LoudnessMeter<SampleType>::weigh (const SampleType* const* channels, int numChannels, int offset,
+                                         int numSamples, SampleType gain, double* state) const noexcept
+{
+    using Vector = SIMDVector<double>;
+
+    auto s1 = Vector::load (state);
+    auto s2 = Vector::load (state + Vector::size);
+    auto s3 = Vector::load (state + 2 * Vector::size);
+    auto s4 = Vector::load (state + 3 * Vector::size);
+
+    const auto shelfB0 = Vector::broadcast (shelf.b0), shelfB1 = Vector::broadcast (shelf.b1);
+    const auto shelfB2 = Vector::broadcast (shelf.b2), shelfA1 = Vector::broadcast (shelf.a1);
+    const auto shelfA2 = Vector::broadcast (shelf.a2);
+    const auto highPassA1 = Vector::broadcast (highPass.a1), highPassA2 = Vector::broadcast (highPass.a2);
+
+    // Interleaved a chunk at a time, so each vector load reads stores made
+    // long before it rather than stalling on the ones just issued. Unused
+    // lanes stay silent.
+    constexpr int chunkLength = 64;
+    double inputs[chunkLength * Vector::size] = {};
+    auto sum = Vector::broadcast (0);
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        const int position = i % chunkLength;
+
+        if (position == 0)
+        {
+            const int n = std::min (chunkLength, numSamples - i);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                for (int j = 0; j < n; ++j)
+                    inputs[j * Vector::size + channel] = (double) (channels[channel][offset + i + j] * gain);
+        }
+
+        const auto x = Vector::load (inputs + position * Vector::size);
+
+        const auto y = shelfB0 * x + s1;
+        s1 = shelfB1 * x - shelfA1 * y + s2;
+        s2 = shelfB2 * x - shelfA2 * y;
+
+        // The high-pass numerator is 1, -2, 1
+        const auto z = y + s3;
+        s3 = s4 - (y + y) - highPassA1 * z;
+        s4 = y - highPassA2 * z;
+
+        sum = sum + z * z;
+    }
+
+    s1.store (state);
+    s2.store (state + Vector::size);
+    s3.store (state + 2 * Vector::size);
+    s4.store (state + 3 * Vector::size);
+
+    double lanes[Vector::size];
+    sum.store (lanes);
+
+    double result = 0.0;
+
+    for (auto lane : lanes)
+        result += lane;
+
+    return result;
+}
+
+template class LoudnessMeter<float>;
+template class LoudnessMeter<double>;
+
+} // namespace VocalDSP
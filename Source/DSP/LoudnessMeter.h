@@ -0,0 +1,87 @@
+/*
+  ==============================================================================
+
+    LoudnessMeter.h
+
+    A streaming short-term loudness estimate after ITU-R BS.1770: the
+    channels are K-weighted by a high shelf and a high-pass biquad, and the
+    mean square of the weighted signal over the last three seconds, summed
+    across channels, is expressed in LUFS. All channels are weighted 1.
+
+    The window is kept as a ring of 100 ms segments. Each block only adds
+    its squares to the current segment; a completed segment enters a
+    running sum and the one it replaces leaves it, so the estimate is
+    updated incrementally and the window is never summed again. Until the
+    window has filled, the completed segments so far are averaged.
+
+    Filter states and sums are kept in double precision: at oversampled
+    rates the high-pass poles sit very close to the unit circle. The
+    filters run across channels, one SIMDVector<double> lane each, like the
+    kernel's detector. The class has no JUCE dependency and does not
+    allocate outside prepare().
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <vector>
+
+#include "SIMD.h"
+
+namespace VocalDSP
+{
+
+template <typename SampleType>
+class LoudnessMeter
+{
+public:
+    static constexpr double windowSeconds = 3.0;
+    static constexpr double segmentSeconds = 0.1;
+
+    /** What getLoudness() returns before anything was measured, and for silence. */
+    static constexpr double silenceLufs = -100.0;
+
+    //==============================================================================
+    void prepare (double sampleRate, int numChannels);
+    void reset() noexcept;
+
+    /** Adds a block of numChannels channels, each sample multiplied by gain. */
+    void process (const SampleType* const* channels, int numChannels, int numSamples,
+                  SampleType gain = 1) noexcept;
+
+    /** The short-term loudness in LUFS. */
+    double getLoudness() const noexcept;
+
+private:
+    //==============================================================================
+    struct Biquad
+    {
+        double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+    };
+
+    /** Filters up to one vector of channels through both stages and returns
+        the sum of squares of the result.
+    */
+    double weigh (const SampleType* const* channels, int numChannels, int offset, int numSamples,
+                  SampleType gain, double* state) const noexcept;
+
+    Biquad shelf, highPass;
+
+    // Transposed direct form II, two states per stage, one vector of each
+    // per group of channels
+    int numChannelsPrepared = 0;
+    std::vector<double> states;
+
+    int segmentLength = 1, segmentPosition = 0;
+    double segmentSum = 0.0;
+
+    std::vector<double> segments;
+    int nextSegment = 0, numSegments = 0;
+    double windowSum = 0.0;
+};
+
+extern template class LoudnessMeter<float>;
+extern template class LoudnessMeter<double>;
+
+} // namespace VocalDSP
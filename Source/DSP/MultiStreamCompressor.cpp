@@ -0,0 +1,244 @@
+/*
+  ==============================================================================
+
+    MultiStreamCompressor.cpp
+
+  ==============================================================================
+*/
+
+#include "MultiStreamCompressor.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace VocalDSP
+{
+
+//==============================================================================
+void MultiStreamCompressor::prepare (double newSampleRate, int newMaximumBlockSize, int newNumStreams)
+{
+    sampleRate = newSampleRate;
+    maximumBlockSize = std::max (1, newMaximumBlockSize);
+    numStreams = std::max (0, newNumStreams);
+
+    const auto numLanes = (size_t) ((numStreams + laneCount - 1) / laneCount * laneCount);
+
+    for (auto* lanes : { &threshold, &ratio, &knee, &makeUpGainDb, &makeUpGain,
+                         &attackCoefficient, &releaseCoefficient, &lowerKneeBoundGain, &envelopeState })
+        lanes->assign (numLanes, 0.0f);
+
+    interleavedBuffer.assign ((size_t) (maximumBlockSize * laneCount), 0.0f);
+    envelopeBuffer.assign ((size_t) (maximumBlockSize * laneCount), 0.0f);
+
+    // The padding lanes keep the defaults too, so they never divide by zero
+    for (size_t lane = 0; lane < numLanes; ++lane)
+        setLaneParameters (lane, {});
+}
+
+void MultiStreamCompressor::reset() noexcept
+{
+    std::fill (envelopeState.begin(), envelopeState.end(), 0.0f);
+}
+
+void MultiStreamCompressor::reset (int stream) noexcept
+{
+    if (stream >= 0 && stream < numStreams)
+        envelopeState[(size_t) stream] = 0.0f;
+}
+
+void MultiStreamCompressor::setParameters (int stream, const Parameters& parameters) noexcept
+{
+    if (stream >= 0 && stream < numStreams)
+        setLaneParameters ((size_t) stream, parameters);
+}
+
+void MultiStreamCompressor::setParameters (const Parameters& parameters) noexcept
+{
+    for (int stream = 0; stream < numStreams; ++stream)
+        setLaneParameters ((size_t) stream, parameters);
+}
+
+void MultiStreamCompressor::setLaneParameters (size_t lane, const Parameters& parameters) noexcept
+{
+    const GainCurve curve { parameters.threshold, parameters.ratio, parameters.knee };
+
+    threshold[lane] = curve.threshold;
+    ratio[lane]     = curve.ratio;
+    knee[lane]      = curve.knee;
+
+    makeUpGainDb[lane] = -curve.getGainReduction (0.0f) * parameters.autoGain;
+    makeUpGain[lane]   = Decibels::decibelsToGain (makeUpGainDb[lane]);
+
+    attackCoefficient[lane]  = calculateCoefficient (parameters.attack);
+    releaseCoefficient[lane] = calculateCoefficient (parameters.release);
+
+    lowerKneeBoundGain[lane] = Decibels::decibelsToGain (parameters.threshold - parameters.knee / 2.0f);
+}
+
+float MultiStreamCompressor::calculateCoefficient (float timeMs) const noexcept
+{
+    // Same time constant as juce::dsp::BallisticsFilter
+    const double expFactor = -2.0 * 3.141592653589793 * 1000.0 / sampleRate;
+    return timeMs < 1.0e-3f ? 0.0f : (float) std::exp (expFactor / timeMs);
+}
+
+//==============================================================================
+void MultiStreamCompressor::process (float* const* streams, int numSamples) noexcept
+{
+    for (int firstStream = 0; firstStream < numStreams; firstStream += laneCount)
+    {
+        const auto* groupEnd = streams + std::min (numStreams, firstStream + laneCount);
+
+        if (std::all_of (streams + firstStream, groupEnd, [] (const float* stream) { return stream == nullptr; }))
+            continue;
+
+        for (int offset = 0; offset < numSamples; offset += maximumBlockSize)
+        {
+            const int n = std::min (maximumBlockSize, numSamples - offset);
+
+            if (skipIdleGroup (streams, firstStream, offset, n))
+                continue;
+
+            switch (accuracy)
+            {
+                case Accuracy::exact:   processGroup<Accuracy::exact> (streams, firstStream, offset, n); break;
+                case Accuracy::high:    processGroup<Accuracy::high>  (streams, firstStream, offset, n); break;
+                case Accuracy::fast:    processGroup<Accuracy::fast>  (streams, firstStream, offset, n); break;
+            }
+        }
+    }
+
+    // Keep long release tails from decaying into denormals
+    for (auto& state : envelopeState)
+        if (std::abs (state) < 1.0e-8f)
+            state = 0.0f;
+}
+
+bool MultiStreamCompressor::skipIdleGroup (float* const* streams, int firstStream,
+                                           int offset, int numSamples) noexcept
+{
+    const int numLanes = std::min (laneCount, numStreams - firstStream);
+    float peaks[laneCount] = {};
+
+    for (int lane = 0; lane < numLanes; ++lane)
+    {
+        const auto stream = (size_t) (firstStream + lane);
+
+        if (streams[stream] == nullptr)
+            continue;
+
+        if (envelopeState[stream] >= lowerKneeBoundGain[stream])
+            return false;
+
+        peaks[lane] = CompressorKernel<float>::getPeak (streams[stream] + offset, numSamples);
+
+        if (peaks[lane] >= lowerKneeBoundGain[stream])
+            return false;
+    }
+
+    for (int lane = 0; lane < numLanes; ++lane)
+    {
+        const auto stream = (size_t) (firstStream + lane);
+
+        if (streams[stream] == nullptr)
+            continue;
+
+        float* samples = streams[stream] + offset;
+        float& state = envelopeState[stream];
+
+        if (peaks[lane] == 0.0f)
+            state *= std::pow (releaseCoefficient[stream], (float) numSamples);
+        else
+            state = CompressorKernel<float>::advance (samples, numSamples, state,
+                                                      attackCoefficient[stream], releaseCoefficient[stream]);
+
+        if (makeUpGain[stream] != 1.0f)
+            CompressorKernel<float>::applyGain (samples, makeUpGain[stream], numSamples);
+    }
+
+    return true;
+}
+
+template <Accuracy accuracy>
+void MultiStreamCompressor::processGroup (float* const* streams, int firstStream,
+                                          int offset, int numSamples) noexcept
+{
+    const int numLanes = std::min (laneCount, numStreams - firstStream);
+    const int numValues = numSamples * laneCount;
+
+    float* input = interleavedBuffer.data();
+    float* envelope = envelopeBuffer.data();
+
+    // Frame i holds sample i of every stream in the group, silence for the
+    // padding and the skipped streams
+    float active[laneCount] = {};
+
+    for (int lane = 0; lane < laneCount; ++lane)
+    {
+        if (lane < numLanes && streams[firstStream + lane] != nullptr)
+        {
+            const float* source = streams[firstStream + lane] + offset;
+            active[lane] = 1.0f;
+
+            for (int i = 0; i < numSamples; ++i)
+                input[i * laneCount + lane] = source[i];
+        }
+        else
+        {
+            for (int i = 0; i < numSamples; ++i)
+                input[i * laneCount + lane] = 0.0f;
+        }
+    }
+
+    // Peak ballistics, one stream per lane
+    {
+        const auto attack  = Vector::load (attackCoefficient.data() + firstStream);
+        const auto release = Vector::load (releaseCoefficient.data() + firstStream);
+        const auto initialState = Vector::load (envelopeState.data() + firstStream);
+        auto state = initialState;
+
+        for (int i = 0; i < numValues; i += laneCount)
+        {
+            const auto level = Vector::abs (Vector::load (input + i));
+            const auto coefficient = Vector::select (Vector::lessThan (state, level), attack, release);
+
+            state = level + coefficient * (state - level);
+            state.store (envelope + i);
+        }
+
+        // The skipped streams carry on from where they were
+        const auto isActive = Vector::lessThan (Vector::broadcast (0.0f), Vector::load (active));
+        Vector::select (isActive, state, initialState).store (envelopeState.data() + firstStream);
+    }
+
+    Decibels::gainToDecibels<accuracy> (envelope, envelope, numValues);
+
+    {
+        const auto thresholds = Vector::load (threshold.data() + firstStream);
+        const auto ratios     = Vector::load (ratio.data() + firstStream);
+        const auto knees      = Vector::load (knee.data() + firstStream);
+        const auto makeUp     = Vector::load (makeUpGainDb.data() + firstStream);
+
+        for (int i = 0; i < numValues; i += laneCount)
+        {
+            const auto gainReduction = GainCurve::getGainReduction (Vector::load (envelope + i),
+                                                                    thresholds, ratios, knees);
+            (gainReduction + makeUp).store (envelope + i);
+        }
+    }
+
+    Decibels::decibelsToGain<accuracy> (envelope, envelope, numValues);
+
+    for (int lane = 0; lane < numLanes; ++lane)
+    {
+        if (streams[firstStream + lane] == nullptr)
+            continue;
+
+        float* samples = streams[firstStream + lane] + offset;
+
+        for (int i = 0; i < numSamples; ++i)
+            samples[i] = input[i * laneCount + lane] * envelope[i * laneCount + lane];
+    }
+}
+
+} // namespace VocalDSP
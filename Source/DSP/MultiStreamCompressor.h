@@ -0,0 +1,110 @@
+/*
+  ==============================================================================
+
+    MultiStreamCompressor.h
+
+    Compresses many independent mono streams in one call, e.g. the voices of
+    a server-side mixer. Streams are handled in groups of SIMDVector<float>
+    lanes, one stream per lane, so the detector recursion that stays scalar
+    in CompressorKernel runs across a whole group at once.
+
+    All per-stream state and settings are kept as structure of arrays, padded
+    up to a multiple of the lane count. For each group and block the streams
+    are interleaved into a scratch buffer, run through
+
+        detect  ->  gain to dB  ->  gain curve  ->  dB to gain  ->  apply
+
+    with every stage working on whole vectors, and written back.
+
+    Since every lane can have its own threshold, ratio and knee, the curve is
+    evaluated in closed form rather than from a GainCurveTable. The result
+    matches CompressorKernel to within the table's interpolation error.
+    Gain is always computed at audio rate from a peak detector without
+    lookahead, with the make-up gain taken from the curve:
+    Parameters::controlInterval, Parameters::link, Parameters::detector,
+    Parameters::lookahead and Parameters::makeUp are ignored, and the dB
+    conversion accuracy is shared by all streams.
+
+    Groups in which no stream can reach the lower knee bound skip the dB
+    conversions and the curve, like CompressorKernel does for a channel.
+
+    A caller that only has some streams ready, such as a server collecting
+    network packets, passes null for the others: those keep their state and
+    a group with no ready stream costs nothing.
+
+    The engine has no JUCE dependency and does not allocate outside prepare().
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <vector>
+
+#include "CompressorKernel.h"
+
+namespace VocalDSP
+{
+
+class MultiStreamCompressor
+{
+public:
+    using Vector = SIMDVector<float>;
+
+    /** The number of streams processed side by side. */
+    static constexpr int laneCount = Vector::size;
+
+    //==============================================================================
+    /** Allocates state for numStreams streams, all set to the default Parameters. */
+    void prepare (double sampleRate, int maximumBlockSize, int numStreams);
+
+    void reset() noexcept;
+    void reset (int stream) noexcept;
+
+    int getNumStreams() const noexcept      { return numStreams; }
+
+    /** Changes the settings of one stream. Call this from the processing
+        thread, between calls to process().
+    */
+    void setParameters (int stream, const Parameters& parameters) noexcept;
+
+    /** Changes the settings of every stream. */
+    void setParameters (const Parameters& parameters) noexcept;
+
+    void setAccuracy (Accuracy newAccuracy) noexcept   { accuracy = newAccuracy; }
+
+    //==============================================================================
+    /** Compresses getNumStreams() mono buffers of numSamples each, in place.
+        Streams whose pointer is null are skipped and keep their state.
+    */
+    void process (float* const* streams, int numSamples) noexcept;
+
+private:
+    //==============================================================================
+    void setLaneParameters (size_t lane, const Parameters&) noexcept;
+
+    /** Runs the fast path if no stream in the group can reach its knee.
+        Returns false, without touching anything, otherwise.
+    */
+    bool skipIdleGroup (float* const* streams, int firstStream, int offset, int numSamples) noexcept;
+
+    template <Accuracy>
+    void processGroup (float* const* streams, int firstStream, int offset, int numSamples) noexcept;
+
+    float calculateCoefficient (float timeMs) const noexcept;
+
+    double sampleRate = 44100.0;
+    int maximumBlockSize = 0;
+    int numStreams = 0;
+    Accuracy accuracy = Accuracy::high;
+
+    // One entry per lane, padded to a multiple of laneCount
+    std::vector<float> threshold, ratio, knee, makeUpGainDb, makeUpGain;
+    std::vector<float> attackCoefficient, releaseCoefficient, lowerKneeBoundGain;
+    std::vector<float> envelopeState;
+
+    // maximumBlockSize frames of laneCount interleaved samples
+    std::vector<float> interleavedBuffer, envelopeBuffer;
+};
+
+} // namespace VocalDSP
@@ -0,0 +1,454 @@
+/*
+  ==============================================================================
+
+    MultibandCompressor.cpp
+
+  ==============================================================================
+*/
+
+#include "MultibandCompressor.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace VocalDSP
+{
+
+namespace
+{
+    template <typename SampleType, typename Vector>
+    SampleType horizontalMin (Vector v) noexcept
+    {
+        SampleType lanes[Vector::size];
+        v.store (lanes);
+
+        auto result = lanes[0];
+
+        for (int lane = 1; lane < Vector::size; ++lane)
+            result = std::min (result, lanes[lane]);
+
+        return result;
+    }
+
+    /** True if any lane of a is not below the same lane of b. */
+    template <typename SampleType, typename Vector>
+    bool anyNotBelow (Vector a, Vector b) noexcept
+    {
+        SampleType lanesA[Vector::size], lanesB[Vector::size];
+        a.store (lanesA);
+        b.store (lanesB);
+
+        for (int lane = 0; lane < Vector::size; ++lane)
+            if (! (lanesA[lane] < lanesB[lane]))
+                return true;
+
+        return false;
+    }
+}
+
+//==============================================================================
+template <typename SampleType>
+void MultibandCompressor<SampleType>::prepare (double newSampleRate, int newMaximumBlockSize, int numChannels)
+{
+    sampleRate = newSampleRate;
+    maximumBlockSize = std::max (1, newMaximumBlockSize);
+    numChannelsPrepared = std::max (0, numChannels);
+
+    // Enough lanes for the largest split, so changing bands never allocates
+    numLanes = (numChannelsPrepared * maximumBands + Vector::size - 1) / Vector::size * Vector::size;
+
+    coefficients.assign ((size_t) (maximumBiquads * 5 * numLanes), 0);
+    filterStates.assign ((size_t) (maximumBiquads * 2 * numLanes), 0);
+
+    for (auto* lanes : { &threshold, &lowerKneeBoundGain, &envelopeState })
+        lanes->assign ((size_t) numLanes, 0);
+
+    bandBuffer.assign ((size_t) (maximumBlockSize * Vector::size), 0);
+    envelopeBuffer.assign ((size_t) (maximumBlockSize * Vector::size), 0);
+    sumBuffer.assign ((size_t) (maximumBlockSize * numChannelsPrepared), 0);
+
+    // Set everything up again on the next call
+    numBands = 0;
+    currentAttack = currentRelease = -1.0f;
+}
+
+template <typename SampleType>
+void MultibandCompressor<SampleType>::reset() noexcept
+{
+    std::fill (filterStates.begin(), filterStates.end(), (SampleType) 0);
+    std::fill (envelopeState.begin(), envelopeState.end(), (SampleType) 0);
+}
+
+template <typename SampleType>
+SampleType MultibandCompressor<SampleType>::calculateCoefficient (float timeMs) const noexcept
+{
+    // Same time constant as juce::dsp::BallisticsFilter
+    const double expFactor = -2.0 * 3.141592653589793 * 1000.0 / sampleRate;
+    return timeMs < 1.0e-3f ? (SampleType) 0 : (SampleType) std::exp (expFactor / timeMs);
+}
+
+//==============================================================================
+template <typename SampleType>
+void MultibandCompressor<SampleType>::setBands (const Bands& bands) noexcept
+{
+    numBands = std::clamp (bands.numBands, 2, maximumBands);
+    numActiveLanes = numChannelsPrepared * numBands;
+
+    // The lanes mean different bands now
+    reset();
+    setCrossovers (bands);
+}
+
+template <typename SampleType>
+void MultibandCompressor<SampleType>::setCrossovers (const Bands& bands) noexcept
+{
+    struct Biquad
+    {
+        double b0, b1, b2, a1, a2;
+    };
+
+    constexpr double pi = 3.141592653589793;
+
+    std::array<Biquad, maximumBands - 1> lowPass, highPass, allPass;
+    double lowest = 20.0;
+
+    // Butterworth sections, bilinear with prewarping; two of them make a
+    // Linkwitz-Riley crossover
+    for (int k = 0; k < numBands - 1; ++k)
+    {
+        const double frequency = std::clamp ((double) bands.crossovers[(size_t) k], lowest, 0.45 * sampleRate);
+        lowest = frequency;
+
+        const double K = std::tan (pi * frequency / sampleRate);
+        const double norm = 1.0 / (1.0 + std::sqrt (2.0) * K + K * K);
+        const double a1 = 2.0 * (K * K - 1.0) * norm;
+        const double a2 = (1.0 - std::sqrt (2.0) * K + K * K) * norm;
+
+        lowPass[(size_t) k]  = { K * K * norm, 2.0 * K * K * norm, K * K * norm, a1, a2 };
+        highPass[(size_t) k] = { norm, -2.0 * norm, norm, a1, a2 };
+        allPass[(size_t) k]  = { a2, a1, 1.0, a1, a2 };
+    }
+
+    const Biquad identity { 1.0, 0.0, 0.0, 0.0, 0.0 };
+
+    for (int lane = 0; lane < numLanes; ++lane)
+    {
+        const int band = lane % numBands;
+        const bool active = lane < numActiveLanes;
+
+        for (int k = 0; k < numBands - 1; ++k)
+        {
+            const auto& section = k < band ? highPass[(size_t) k] : k == band ? lowPass[(size_t) k] : allPass[(size_t) k];
+
+            // Padding lanes pass their silence through
+            const auto& first  = active ? section : identity;
+            const auto& second = active && k <= band ? section : identity;
+
+            int biquad = 2 * k;
+
+            for (const auto* b : { &first, &second })
+            {
+                getCoefficients (biquad, 0)[lane] = (SampleType) b->b0;
+                getCoefficients (biquad, 1)[lane] = (SampleType) b->b1;
+                getCoefficients (biquad, 2)[lane] = (SampleType) b->b2;
+                getCoefficients (biquad, 3)[lane] = (SampleType) b->a1;
+                getCoefficients (biquad, 4)[lane] = (SampleType) b->a2;
+                ++biquad;
+            }
+        }
+    }
+
+    currentBands.numBands = numBands;
+    currentBands.crossovers = bands.crossovers;
+}
+
+template <typename SampleType>
+void MultibandCompressor<SampleType>::setThresholds (const Parameters& parameters, const Bands& bands) noexcept
+{
+    const GainCurve curve { parameters.threshold, parameters.ratio, parameters.knee };
+
+    ratio = (SampleType) curve.ratio;
+    knee  = (SampleType) curve.knee;
+
+    // The single band make-up, so the offsets only take level away
+    makeUpGainDb = (SampleType) -curve.getGainReduction (0.0f);
+
+    for (int lane = 0; lane < numLanes; ++lane)
+    {
+        const auto bandThreshold = parameters.threshold + bands.thresholdOffsets[(size_t) (lane % numBands)];
+
+        threshold[(size_t) lane] = (SampleType) bandThreshold;
+        lowerKneeBoundGain[(size_t) lane] = Decibels::decibelsToGain ((SampleType) (bandThreshold - parameters.knee / 2.0f));
+    }
+
+    currentThreshold = parameters.threshold;
+    currentRatio = parameters.ratio;
+    currentKnee = parameters.knee;
+    currentBands.thresholdOffsets = bands.thresholdOffsets;
+}
+
+//==============================================================================
+template <typename SampleType>
+void MultibandCompressor<SampleType>::process (SampleType* const* channels, int numChannels, int numSamples,
+                                               const Parameters& parameters, const Bands& bands) noexcept
+{
+    numChannels = std::min (numChannels, numChannelsPrepared);
+
+    // Filters, thresholds and ballistics are only set up again when their settings move
+    const bool split = std::clamp (bands.numBands, 2, maximumBands) != numBands;
+
+    if (split)
+        setBands (bands);
+    else if (bands.crossovers != currentBands.crossovers)
+        setCrossovers (bands);
+
+    if (split || parameters.threshold != currentThreshold || parameters.ratio != currentRatio
+         || parameters.knee != currentKnee || bands.thresholdOffsets != currentBands.thresholdOffsets)
+        setThresholds (parameters, bands);
+
+    if (parameters.attack != currentAttack || parameters.release != currentRelease)
+    {
+        attackCoefficient  = calculateCoefficient (parameters.attack);
+        releaseCoefficient = calculateCoefficient (parameters.release);
+        currentAttack = parameters.attack;
+        currentRelease = parameters.release;
+    }
+
+    accuracy = parameters.accuracy;
+
+    const auto blockMakeUpGainDb = makeUpGainDb * (SampleType) parameters.autoGain;
+    makeUpGain = Decibels::decibelsToGain (blockMakeUpGainDb);
+
+    if (metering)
+    {
+        levels = {};
+        levels.minimumGain = 1;
+    }
+
+    for (int offset = 0; offset < numSamples; offset += maximumBlockSize)
+    {
+        const int n = std::min (maximumBlockSize, numSamples - offset);
+
+        // The channels are only overwritten once every group has read them
+        std::fill (sumBuffer.begin(), sumBuffer.begin() + numChannels * n, (SampleType) 0);
+
+        // A split that fits in a narrower vector, e.g. stereo 2 bands with
+        // float AVX, would leave half of every native vector idle
+        if (numChannels * numBands <= NarrowSIMDVector<SampleType>::size)
+            processGroups<NarrowSIMDVector<SampleType>> (channels, numChannels, offset, n);
+        else
+            processGroups<Vector> (channels, numChannels, offset, n);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            SampleType* samples = channels[channel] + offset;
+            const SampleType* sum = sumBuffer.data() + channel * n;
+
+            if (metering)
+            {
+                SampleType inputSquares = 0, outputSquares = 0;
+                const auto inputPeak = CompressorKernel<SampleType>::getPeak (samples, n, &inputSquares);
+
+                std::copy (sum, sum + n, samples);
+                CompressorKernel<SampleType>::applyGain (samples, makeUpGain, n);
+
+                const auto outputPeak = CompressorKernel<SampleType>::getPeak (samples, n, &outputSquares);
+                levels.add (inputPeak, inputSquares, outputPeak, outputSquares, 1, n);
+            }
+            else
+            {
+                std::copy (sum, sum + n, samples);
+                CompressorKernel<SampleType>::applyGain (samples, makeUpGain, n);
+            }
+        }
+    }
+
+    // Keep the filters and release tails from decaying into denormals
+    for (auto& state : filterStates)
+        if (std::abs (state) < (SampleType) 1.0e-15)
+            state = 0;
+
+    for (auto& state : envelopeState)
+        if (std::abs (state) < (SampleType) 1.0e-8)
+            state = 0;
+
+    if (metering)
+    {
+        // minimumGain has held the lowest band gain so far, without make-up
+        levels.gainReductionDb = std::min ((SampleType) 0, Decibels::gainToDecibels (levels.minimumGain));
+        levels.minimumGain *= makeUpGain;
+    }
+}
+
+template <typename SampleType>
+template <typename GroupVector>
+void MultibandCompressor<SampleType>::processGroups (const SampleType* const* channels, int numChannels,
+                                                     int offset, int numSamples) noexcept
+{
+    // Only the lanes of the channels passed in, in whole groups
+    const int lanesInUse = numChannels * numBands;
+
+    for (int firstLane = 0; firstLane < lanesInUse; firstLane += GroupVector::size)
+    {
+        switch (accuracy)
+        {
+            case Accuracy::exact:   processGroup<Accuracy::exact, GroupVector> (channels, numChannels, offset, firstLane, numSamples); break;
+            case Accuracy::high:    processGroup<Accuracy::high,  GroupVector> (channels, numChannels, offset, firstLane, numSamples); break;
+            case Accuracy::fast:    processGroup<Accuracy::fast,  GroupVector> (channels, numChannels, offset, firstLane, numSamples); break;
+        }
+    }
+}
+
+template <typename SampleType>
+template <int numCrossovers, typename GroupVector>
+void MultibandCompressor<SampleType>::filter (SampleType* samples, int numSamples, int firstLane) noexcept
+{
+    constexpr int numBiquads = 2 * numCrossovers;
+
+    GroupVector b0[numBiquads], b1[numBiquads], b2[numBiquads], a1[numBiquads], a2[numBiquads];
+    GroupVector s1[numBiquads], s2[numBiquads];
+
+    for (int k = 0; k < numBiquads; ++k)
+    {
+        b0[k] = GroupVector::load (getCoefficients (k, 0) + firstLane);
+        b1[k] = GroupVector::load (getCoefficients (k, 1) + firstLane);
+        b2[k] = GroupVector::load (getCoefficients (k, 2) + firstLane);
+        a1[k] = GroupVector::load (getCoefficients (k, 3) + firstLane);
+        a2[k] = GroupVector::load (getCoefficients (k, 4) + firstLane);
+        s1[k] = GroupVector::load (getStates (k, 0) + firstLane);
+        s2[k] = GroupVector::load (getStates (k, 1) + firstLane);
+    }
+
+    // Transposed direct form II. All biquads advance per frame, so the
+    // recursions of consecutive sections overlap rather than wait on each
+    // other.
+    for (int i = 0; i < numSamples * GroupVector::size; i += GroupVector::size)
+    {
+        auto x = GroupVector::load (samples + i);
+
+        for (int k = 0; k < numBiquads; ++k)
+        {
+            const auto y = b0[k] * x + s1[k];
+            s1[k] = b1[k] * x - a1[k] * y + s2[k];
+            s2[k] = b2[k] * x - a2[k] * y;
+            x = y;
+        }
+
+        x.store (samples + i);
+    }
+
+    for (int k = 0; k < numBiquads; ++k)
+    {
+        s1[k].store (getStates (k, 0) + firstLane);
+        s2[k].store (getStates (k, 1) + firstLane);
+    }
+}
+
+template <typename SampleType>
+template <Accuracy accuracy, typename GroupVector>
+void MultibandCompressor<SampleType>::processGroup (const SampleType* const* channels, int numChannels, int offset,
+                                                    int firstLane, int numSamples) noexcept
+{
+    const int numValues = numSamples * GroupVector::size;
+
+    SampleType* bandSamples = bandBuffer.data();
+    SampleType* envelope = envelopeBuffer.data();
+
+    // Frame i holds sample i of every lane's channel, silence for the padding
+    for (int lane = 0; lane < GroupVector::size; ++lane)
+    {
+        const int channel = (firstLane + lane) / numBands;
+
+        if (channel < numChannels)
+        {
+            const SampleType* source = channels[channel] + offset;
+
+            for (int i = 0; i < numSamples; ++i)
+                bandSamples[i * GroupVector::size + lane] = source[i];
+        }
+        else
+        {
+            for (int i = 0; i < numSamples; ++i)
+                bandSamples[i * GroupVector::size + lane] = 0;
+        }
+    }
+
+    switch (numBands)
+    {
+        case 2:     filter<1, GroupVector> (bandSamples, numSamples, firstLane); break;
+        case 3:     filter<2, GroupVector> (bandSamples, numSamples, firstLane); break;
+        default:    filter<3, GroupVector> (bandSamples, numSamples, firstLane); break;
+    }
+
+    // Peak ballistics, one band per lane, keeping the loudest envelope
+    const auto lowerKneeBound = GroupVector::load (lowerKneeBoundGain.data() + firstLane);
+    auto loudest = GroupVector::broadcast (0);
+
+    {
+        const auto attack  = GroupVector::broadcast (attackCoefficient);
+        const auto release = GroupVector::broadcast (releaseCoefficient);
+        auto state = GroupVector::load (envelopeState.data() + firstLane);
+
+        for (int i = 0; i < numValues; i += GroupVector::size)
+        {
+            const auto level = GroupVector::abs (GroupVector::load (bandSamples + i));
+            const auto coefficient = GroupVector::select (GroupVector::lessThan (state, level), attack, release);
+
+            state = level + coefficient * (state - level);
+            state.store (envelope + i);
+            loudest = GroupVector::max (loudest, state);
+        }
+
+        state.store (envelopeState.data() + firstLane);
+    }
+
+    const int numLanesUsed = std::min ((int) GroupVector::size, numChannels * numBands - firstLane);
+
+    // Below every lower knee bound the gain is exactly one
+    if (anyNotBelow<SampleType> (loudest, lowerKneeBound))
+    {
+        Decibels::gainToDecibels<accuracy> (envelope, envelope, numValues);
+
+        const auto thresholds = GroupVector::load (threshold.data() + firstLane);
+        const auto ratios     = GroupVector::broadcast (ratio);
+        const auto knees      = GroupVector::broadcast (knee);
+        auto lowest = GroupVector::broadcast (0);
+
+        for (int i = 0; i < numValues; i += GroupVector::size)
+        {
+            const auto gainReduction = GainCurve::getGainReduction (GroupVector::load (envelope + i),
+                                                                    thresholds, ratios, knees);
+            gainReduction.store (envelope + i);
+            lowest = GroupVector::min (lowest, gainReduction);
+        }
+
+        Decibels::decibelsToGain<accuracy> (envelope, envelope, numValues);
+
+        for (int lane = 0; lane < numLanesUsed; ++lane)
+        {
+            SampleType* sum = sumBuffer.data() + ((firstLane + lane) / numBands) * numSamples;
+
+            for (int i = 0; i < numSamples; ++i)
+                sum[i] += bandSamples[i * GroupVector::size + lane] * envelope[i * GroupVector::size + lane];
+        }
+
+        if (metering)
+            levels.minimumGain = std::min (levels.minimumGain,
+                                           Decibels::decibelsToGain (horizontalMin<SampleType> (lowest)));
+    }
+    else
+    {
+        for (int lane = 0; lane < numLanesUsed; ++lane)
+        {
+            SampleType* sum = sumBuffer.data() + ((firstLane + lane) / numBands) * numSamples;
+
+            for (int i = 0; i < numSamples; ++i)
+                sum[i] += bandSamples[i * GroupVector::size + lane];
+        }
+    }
+}
+
+template class MultibandCompressor<float>;
+template class MultibandCompressor<double>;
+
+} // namespace VocalDSP
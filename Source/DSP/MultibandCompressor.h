@@ -0,0 +1,167 @@
+/*
+  ==============================================================================
+
+    MultibandCompressor.h
+
+    Splits each channel into 2 to 4 bands with 4th order Linkwitz-Riley
+    crossovers, compresses every band with its own detector and gain curve
+    and sums the bands again.
+
+    Every (channel, band) pair is one SIMDVector lane, lane = channel *
+    numBands + band, and all per-lane state and settings are kept as
+    structure of arrays, padded up to a multiple of the lane count. A
+    stereo 4 band split with float AVX is a single vector. Splits with no
+    more lanes than a NarrowSIMDVector, such as stereo 2 bands with float
+    AVX, run in that instead: an AVX vector would cost the same with half
+    its lanes idle, making 2 bands dearer than two CompressorKernels. For
+    each group of lanes and block, every lane gets its channel's input and
+    then runs
+
+        crossover  ->  detect  ->  gain to dB  ->  gain curve  ->  dB to gain  ->  apply
+
+    with every stage working on whole vectors, before the lanes are summed
+    back into their channels.
+
+    So that every lane runs the same filter structure, band b is the
+    cascade over all crossovers k of
+
+        the high-pass of k     for k < b
+        the low-pass of k      for k = b
+        the all-pass of k      for k > b
+
+    where the all-pass, the sum of the low-pass and high-pass, is what the
+    bands below crossover k have to go through to stay in phase with those
+    above it. The bands then sum to the all-pass of every crossover: a flat
+    magnitude response. Each crossover is two biquads per lane; an all-pass
+    is one biquad and an identity.
+
+    Every band follows the same Parameters, with its threshold moved by its
+    entry in Bands::thresholdOffsets, through the closed form curve of
+    GainCurve::getGainReduction(). The make-up gain is the single band
+    curve's, applied to the sum, so an offset only ever takes level away.
+    Gain is computed at audio rate from a peak detector without lookahead:
+    Parameters::controlInterval, Parameters::link, Parameters::detector,
+    Parameters::lookahead and Parameters::makeUp are ignored. Groups whose
+    envelopes all stay below their lower knee bound skip the dB conversions
+    and the curve, as their gain is exactly one. The metered gain reduction
+    is that of the band reduced the most.
+
+    The engine has no JUCE dependency and does not allocate outside prepare().
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "CompressorKernel.h"
+
+namespace VocalDSP
+{
+
+/** The band split, on top of the Parameters shared by all bands. */
+struct Bands
+{
+    static constexpr int maximumBands = 4;
+
+    int numBands = 3;                                                               // 2 to maximumBands
+    std::array<float, maximumBands - 1> crossovers { 250.0f, 2500.0f, 7000.0f };    // Hz, ascending
+    std::array<float, maximumBands> thresholdOffsets {};                            // dB, added to the threshold
+};
+
+//==============================================================================
+template <typename SampleType>
+class MultibandCompressor
+{
+public:
+    using Vector = SIMDVector<SampleType>;
+    using Levels = typename CompressorKernel<SampleType>::Levels;
+    using Bands = VocalDSP::Bands;
+
+    static constexpr int maximumBands = Bands::maximumBands;
+
+    //==============================================================================
+    void prepare (double sampleRate, int maximumBlockSize, int numChannels);
+    void reset() noexcept;
+
+    /** Compresses numChannels buffers in place. Channels beyond the number
+        passed to prepare() are left untouched.
+    */
+    void process (SampleType* const* channels, int numChannels, int numSamples,
+                  const Parameters& parameters, const Bands& bands) noexcept;
+
+    /** Levels are only gathered while enabled, otherwise they cost nothing. */
+    void setMeteringEnabled (bool shouldMeter) noexcept     { metering = shouldMeter; }
+
+    /** The levels of the last process() call with metering enabled. */
+    const Levels& getLevels() const noexcept                { return levels; }
+
+private:
+    //==============================================================================
+    static constexpr int maximumBiquads = 2 * (maximumBands - 1);
+
+    void setBands (const Bands&) noexcept;
+    void setCrossovers (const Bands&) noexcept;
+    void setThresholds (const Parameters&, const Bands&) noexcept;
+
+    SampleType calculateCoefficient (float timeMs) const noexcept;
+
+    template <typename GroupVector>
+    void processGroups (const SampleType* const* channels, int numChannels, int offset, int numSamples) noexcept;
+
+    template <Accuracy, typename GroupVector>
+    void processGroup (const SampleType* const* channels, int numChannels, int offset,
+                       int firstLane, int numSamples) noexcept;
+
+    template <int numCrossovers, typename GroupVector>
+    void filter (SampleType* samples, int numSamples, int firstLane) noexcept;
+
+    SampleType* getCoefficients (int biquad, int coefficient) noexcept
+    {
+        return coefficients.data() + (size_t) ((biquad * 5 + coefficient) * numLanes);
+    }
+
+    SampleType* getStates (int biquad, int state) noexcept
+    {
+        return filterStates.data() + (size_t) ((biquad * 2 + state) * numLanes);
+    }
+
+    double sampleRate = 44100.0;
+    int maximumBlockSize = 0;
+    int numChannelsPrepared = 0;
+
+    // Lanes allocated for maximumBands, and those in use for the current split
+    int numLanes = 0, numActiveLanes = 0;
+    int numBands = 0;
+
+    // The settings the lanes were last set up for
+    Bands currentBands;
+    float currentThreshold = 0.0f, currentRatio = 0.0f, currentKnee = 0.0f;
+    float currentAttack = -1.0f, currentRelease = -1.0f;
+
+    // Shared by all lanes
+    SampleType ratio = 4, knee = 18;
+    SampleType makeUpGainDb = 0, makeUpGain = 1;
+    SampleType attackCoefficient = 0, releaseCoefficient = 0;
+    Accuracy accuracy = Accuracy::high;
+
+    // b0, b1, b2, a1, a2 and the two states of every biquad, one entry per lane
+    std::vector<SampleType> coefficients, filterStates;
+
+    // One entry per lane
+    std::vector<SampleType> threshold, lowerKneeBoundGain, envelopeState;
+
+    // maximumBlockSize frames of Vector::size interleaved lanes, and the sum
+    // of the bands per channel
+    std::vector<SampleType> bandBuffer, envelopeBuffer, sumBuffer;
+
+    bool metering = false;
+    Levels levels;
+};
+
+extern template class MultibandCompressor<float>;
+extern template class MultibandCompressor<double>;
+
+} // namespace VocalDSP
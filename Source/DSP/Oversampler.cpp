@@ -0,0 +1,284 @@
+/*
+  ==============================================================================
+
+    Oversampler.cpp
+
+  ==============================================================================
+*/
+
+#include "Oversampler.h"
+
+#include <cmath>
+
+namespace VocalDSP
+{
+
+namespace
+{
+    // Coefficient pairs per stage, from the base rate up. With this Kaiser
+    // window a round trip is flat to within 0.01 dB up to 0.41 of the base
+    // rate, and every stage rejects images of that band by more than 90 dB.
+    constexpr int stagePairs[] = { 16, 8, 7 };
+    constexpr double kaiserBeta = 9.0;
+
+    /** The zeroth order modified Bessel function of the first kind. */
+    double besselI0 (double x)
+    {
+        double sum = 1.0, term = 1.0;
+
+        for (int k = 1; k < 50 && term > 1.0e-12 * sum; ++k)
+        {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+        }
+
+        return sum;
+    }
+
+    /** y[m] = sum h[i] * (x[m-K+1+i] + x[m-K-i]), reading up to 2K - 1 samples before x. */
+    template <typename SampleType>
+    void filterHalfBand (const SampleType* x, SampleType* y, int numSamples,
+                         const SampleType* h, int numPairs) noexcept
+    {
+        using Vector = SIMDVector<SampleType>;
+
+        constexpr int numVectors = 4;
+
+        const SampleType* newer = x - numPairs + 1;
+        const SampleType* older = x - numPairs;
+        int m = 0;
+
+        // Several outputs at once, so the sums are independent chains of additions
+        for (; m <= numSamples - numVectors * Vector::size; m += numVectors * Vector::size)
+        {
+            Vector sums[numVectors];
+
+            for (int v = 0; v < numVectors; ++v)
+                sums[v] = Vector::broadcast (0);
+
+            for (int i = 0; i < numPairs; ++i)
+            {
+                const auto coefficient = Vector::broadcast (h[i]);
+
+                for (int v = 0; v < numVectors; ++v)
+                {
+                    const int j = m + v * Vector::size;
+                    sums[v] = sums[v] + coefficient * (Vector::load (newer + j + i) + Vector::load (older + j - i));
+                }
+            }
+
+            for (int v = 0; v < numVectors; ++v)
+                sums[v].store (y + m + v * Vector::size);
+        }
+
+        for (; m <= numSamples - Vector::size; m += Vector::size)
+        {
+            auto sum = Vector::broadcast (h[0]) * (Vector::load (newer + m) + Vector::load (older + m));
+
+            for (int i = 1; i < numPairs; ++i)
+                sum = sum + Vector::broadcast (h[i]) * (Vector::load (newer + m + i) + Vector::load (older + m - i));
+
+            sum.store (y + m);
+        }
+
+        for (; m < numSamples; ++m)
+        {
+            SampleType sum = 0;
+
+            for (int i = 0; i < numPairs; ++i)
+                sum += h[i] * (newer[m + i] + older[m - i]);
+
+            y[m] = sum;
+        }
+    }
+}
+
+//==============================================================================
+template <typename SampleType>
+void Oversampler<SampleType>::prepare (int newMaximumBlockSize, int numChannels)
+{
+    maximumBlockSize = std::max (1, newMaximumBlockSize);
+    numChannels = std::max (0, numChannels);
+
+    int maximumHistory = 0;
+
+    for (int s = 0; s < maximumStages; ++s)
+    {
+        auto& stage = stages[s];
+        stage.numPairs = stagePairs[s];
+        stage.historyLength = 2 * stage.numPairs - 1 + getPadding (s + 1);
+        stage.coefficients.assign ((size_t) stage.numPairs, 0);
+
+        // Windowed sinc over the 4K - 1 taps, normalised so the odd taps on both
+        // sides add up to 1/2, like the centre tap
+        const int halfLength = 2 * stage.numPairs;
+        double sum = 0.0;
+        std::vector<double> taps ((size_t) stage.numPairs);
+
+        for (int i = 0; i < stage.numPairs; ++i)
+        {
+            const int n = 2 * i + 1;
+            const double ratio = (double) n / halfLength;
+            const double sinc = (i % 2 == 0 ? 1.0 : -1.0) / (3.141592653589793 * n);
+
+            taps[(size_t) i] = sinc * besselI0 (kaiserBeta * std::sqrt (1.0 - ratio * ratio));
+            sum += taps[(size_t) i];
+        }
+
+        for (int i = 0; i < stage.numPairs; ++i)
+            stage.coefficients[(size_t) i] = (SampleType) (taps[(size_t) i] * 0.25 / sum);
+
+        maximumHistory = std::max (maximumHistory, stage.historyLength);
+    }
+
+    const int maximumInput = maximumBlockSize << (maximumStages - 1);
+
+    inputBuffer.assign ((size_t) (maximumHistory + maximumInput), 0);
+    evenBuffer.assign ((size_t) (maximumHistory + maximumInput), 0);
+    oddBuffer.assign ((size_t) (maximumHistory + maximumInput), 0);
+    stageBuffer.assign ((size_t) maximumInput, 0);
+
+    historyBuffer.assign ((size_t) (3 * maximumHistory * maximumStages * numChannels), 0);
+    histories.assign ((size_t) (maximumStages * numChannels), {});
+
+    for (size_t i = 0; i < histories.size(); ++i)
+    {
+        SampleType* first = historyBuffer.data() + 3 * maximumHistory * i;
+        histories[i] = { first, first + maximumHistory, first + 2 * maximumHistory };
+    }
+
+    const int maximumOversampled = maximumBlockSize << maximumStages;
+
+    oversampledBuffer.assign ((size_t) (maximumOversampled * numChannels), 0);
+    oversampledChannels.assign ((size_t) numChannels, nullptr);
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        oversampledChannels[(size_t) channel] = oversampledBuffer.data() + maximumOversampled * channel;
+
+    reset();
+}
+
+template <typename SampleType>
+void Oversampler<SampleType>::reset() noexcept
+{
+    std::fill (historyBuffer.begin(), historyBuffer.end(), (SampleType) 0);
+}
+
+template <typename SampleType>
+int Oversampler<SampleType>::getPadding (int numStages) noexcept
+{
+    if (numStages <= 1)
+        return 0;
+
+    // The round trip in samples at the rate of the top stage's input
+    const int topRate = 1 << (numStages - 1);
+    int delay = 0;
+
+    for (int s = 0; s < numStages; ++s)
+        delay += (2 * stagePairs[s] - 1) << (numStages - 1 - s);
+
+    return (topRate - delay % topRate) % topRate;
+}
+
+template <typename SampleType>
+int Oversampler<SampleType>::getLatencySamples (int numStages) noexcept
+{
+    numStages = std::clamp (numStages, 0, maximumStages);
+
+    if (numStages == 0)
+        return 0;
+
+    int delay = getPadding (numStages);
+
+    for (int s = 0; s < numStages; ++s)
+        delay += (2 * stagePairs[s] - 1) << (numStages - 1 - s);
+
+    return delay >> (numStages - 1);
+}
+
+//==============================================================================
+template <typename SampleType>
+void Oversampler<SampleType>::upsample (const SampleType* source, int channel, int numSamples, int numStages) noexcept
+{
+    for (int s = 0; s < numStages; ++s)
+    {
+        SampleType* dest = s == numStages - 1 ? oversampledChannels[(size_t) channel] : stageBuffer.data();
+
+        upsampleStage (stages[s], histories[(size_t) (channel * maximumStages + s)].up,
+                       source, dest, numSamples << s);
+        source = dest;
+    }
+}
+
+template <typename SampleType>
+void Oversampler<SampleType>::downsample (SampleType* dest, int channel, int numSamples, int numStages) noexcept
+{
+    const SampleType* source = oversampledChannels[(size_t) channel];
+
+    for (int s = numStages; --s >= 0;)
+    {
+        SampleType* stageDest = s == 0 ? dest : stageBuffer.data();
+
+        downsampleStage (stages[s], histories[(size_t) (channel * maximumStages + s)], source, stageDest,
+                         numSamples << s, s == numStages - 1 ? getPadding (numStages) : 0);
+        source = stageDest;
+    }
+}
+
+template <typename SampleType>
+void Oversampler<SampleType>::upsampleStage (const Stage& stage, SampleType* history, const SampleType* source,
+                                             SampleType* dest, int numSamples) noexcept
+{
+    const int length = stage.historyLength;
+    SampleType* input = inputBuffer.data();
+
+    // The source is copied before dest is written, so the two may overlap
+    std::copy (history, history + length, input);
+    std::copy (source, source + numSamples, input + length);
+
+    SampleType* even = evenBuffer.data();
+    filterHalfBand (input + length, even, numSamples, stage.coefficients.data(), stage.numPairs);
+
+    const SampleType* delayed = input + length - stage.numPairs + 1;
+
+    for (int m = 0; m < numSamples; ++m)
+    {
+        dest[2 * m]     = 2 * even[m];
+        dest[2 * m + 1] = delayed[m];
+    }
+
+    std::copy (input + numSamples, input + numSamples + length, history);
+}
+
+template <typename SampleType>
+void Oversampler<SampleType>::downsampleStage (const Stage& stage, const History& history, const SampleType* source,
+                                               SampleType* dest, int numSamples, int padding) noexcept
+{
+    const int length = stage.historyLength;
+    SampleType* even = evenBuffer.data();
+    SampleType* odd = oddBuffer.data();
+
+    std::copy (history.downEven, history.downEven + length, even);
+    std::copy (history.downOdd, history.downOdd + length, odd);
+
+    for (int m = 0; m < numSamples; ++m)
+    {
+        even[length + m] = source[2 * m];
+        odd[length + m]  = source[2 * m + 1];
+    }
+
+    filterHalfBand (even + length - padding, dest, numSamples, stage.coefficients.data(), stage.numPairs);
+
+    const SampleType* delayed = odd + length - stage.numPairs - padding;
+
+    for (int m = 0; m < numSamples; ++m)
+        dest[m] += (SampleType) 0.5 * delayed[m];
+
+    std::copy (even + numSamples, even + numSamples + length, history.downEven);
+    std::copy (odd + numSamples, odd + numSamples + length, history.downOdd);
+}
+
+template class Oversampler<float>;
+template class Oversampler<double>;
+
+} // namespace VocalDSP
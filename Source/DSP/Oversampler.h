@@ -0,0 +1,164 @@
+/*
+  ==============================================================================
+
+    Oversampler.h
+
+    Runs a processing function at 2, 4 or 8 times the sample rate. Fast gain
+    changes modulate the signal with sidebands well above the input's
+    bandwidth; at the base rate those fold back as aliasing, at a higher
+    rate they land above the original Nyquist frequency and the
+    downsampling filters remove them.
+
+    Each factor of two is one stage of linear phase half-band FIR filters.
+    Every other coefficient of a half-band filter is zero apart from the
+    centre tap, so in polyphase form one output phase is a plain delay and
+    the other a symmetric FIR with half the taps, run at the lower rate:
+
+        up      y[2m]   = 2 * sum h[2i+1] * (x[m-K+1+i] + x[m-K-i])
+                y[2m+1] = x[m-K+1]
+
+        down    y[m]    = sum h[2i+1] * (e[m-K+1+i] + e[m-K-i]) + o[m-K] / 2
+
+    where K is the number of coefficient pairs and e and o are the even and
+    odd input samples. The FIR is vectorised with SIMDVector along time.
+
+    The first stage has the narrowest transition band and the most taps;
+    the later ones only need to suppress images far from the signal, so
+    they get shorter. A round trip through stage s delays by 2K - 1 samples
+    at 2^(s-1) times the base rate, and the top stage pads its
+    downsampler so that the total latency is a whole number of base rate
+    samples, see getLatencySamples().
+
+    The coefficients are designed and all buffers sized in prepare(), so
+    processing and changing the factor never allocate. The class has no JUCE
+    dependency.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "SIMD.h"
+
+namespace VocalDSP
+{
+
+template <typename SampleType>
+class Oversampler
+{
+public:
+    /** 8x. */
+    static constexpr int maximumStages = 3;
+
+    //==============================================================================
+    /** Designs the filters and allocates buffers for up to maximumBlockSize
+        samples per call at the base rate.
+    */
+    void prepare (int maximumBlockSize, int numChannels);
+
+    void reset() noexcept;
+
+    /** The delay of a round trip through numStages stages, in samples at the
+        base rate. Zero stages add no delay.
+    */
+    static int getLatencySamples (int numStages) noexcept;
+
+    //==============================================================================
+    /** Upsamples the channels by 2^numStages, hands them to the function and
+        downsamples the result back into the channels. Longer buffers than
+        the prepared block size are processed in several calls of
+
+            processOversampled (SampleType* const* channels, int numChannels, int numSamples)
+
+        Changing numStages clears the filter states.
+    */
+    template <typename ProcessFunction>
+    void process (SampleType* const* channels, int numChannels, int numSamples, int numStages,
+                  ProcessFunction&& processOversampled) noexcept
+    {
+        numChannels = std::min (numChannels, (int) histories.size() / maximumStages);
+        numStages = std::clamp (numStages, 0, maximumStages);
+
+        if (numStages != activeStages)
+        {
+            reset();
+            activeStages = numStages;
+        }
+
+        if (numStages == 0)
+        {
+            processOversampled (channels, numChannels, numSamples);
+            return;
+        }
+
+        for (int offset = 0; offset < numSamples; offset += maximumBlockSize)
+        {
+            const int n = std::min (maximumBlockSize, numSamples - offset);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                upsample (channels[channel] + offset, channel, n, numStages);
+
+            processOversampled (oversampledChannels.data(), numChannels, n << numStages);
+
+            for (int channel = 0; channel < numChannels; ++channel)
+                downsample (channels[channel] + offset, channel, n, numStages);
+        }
+    }
+
+private:
+    //==============================================================================
+    struct Stage
+    {
+        int numPairs = 0;
+        int historyLength = 0;
+
+        // h[2i+1] for i below numPairs, the centre tap is 1/2
+        std::vector<SampleType> coefficients;
+    };
+
+    /** The last historyLength inputs of each filter of one stage and channel. */
+    struct History
+    {
+        SampleType* up = nullptr;
+        SampleType* downEven = nullptr;
+        SampleType* downOdd = nullptr;
+    };
+
+    void upsample (const SampleType* source, int channel, int numSamples, int numStages) noexcept;
+    void downsample (SampleType* dest, int channel, int numSamples, int numStages) noexcept;
+
+    /** Doubles the rate of numSamples samples into 2 * numSamples at dest. */
+    void upsampleStage (const Stage&, SampleType* history, const SampleType* source,
+                        SampleType* dest, int numSamples) noexcept;
+
+    /** Halves the rate of 2 * numSamples samples into numSamples at dest, delayed by padding. */
+    void downsampleStage (const Stage&, const History&, const SampleType* source,
+                          SampleType* dest, int numSamples, int padding) noexcept;
+
+    /** Pads the top stage's downsampler so that the total latency is whole. */
+    static int getPadding (int numStages) noexcept;
+
+    int maximumBlockSize = 0;
+    int activeStages = 0;
+
+    Stage stages[maximumStages];
+
+    // Stage by stage for each channel
+    std::vector<SampleType> historyBuffer;
+    std::vector<History> histories;
+
+    // Shared by all channels, which are filtered one after another
+    std::vector<SampleType> inputBuffer, oddBuffer, evenBuffer, stageBuffer;
+
+    // maximumBlockSize << maximumStages samples per channel
+    std::vector<SampleType> oversampledBuffer;
+    std::vector<SampleType*> oversampledChannels;
+};
+
+extern template class Oversampler<float>;
+extern template class Oversampler<double>;
+
+} // namespace VocalDSP
@@ -0,0 +1,529 @@
+/*
+  ==============================================================================
+
+    SIMD.h
+
+    A minimal register wrapper used by the block-based compressor stages.
+    Every instruction set exposes the same operations for float and double
+    lanes, so the stages are written once as templates. ScalarVector
+    evaluates exactly the same arithmetic one lane at a time; it is used for
+    block tails and as the fallback when no vector instruction set is
+    available, e.g. for double on 32 bit ARM. With AVX2 the SSE2 types are
+    built as well, for work too narrow to fill an AVX vector.
+
+    Define VOCALCOMPRESSOR_FORCE_SCALAR to disable the vector paths.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#if ! defined (VOCALCOMPRESSOR_FORCE_SCALAR)
+ #if defined (__AVX2__)
+  #include <immintrin.h>
+  #define VOCALCOMPRESSOR_SIMD_AVX 1
+ #elif defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define VOCALCOMPRESSOR_SIMD_SSE 1
+ #elif defined (__ARM_NEON) || defined (__ARM_NEON__) || defined (_M_ARM64)
+  #include <arm_neon.h>
+  #define VOCALCOMPRESSOR_SIMD_NEON 1
+ #endif
+#endif
+
+namespace VocalDSP
+{
+
+//==============================================================================
+/** One lane of any SIMD vector. */
+template <typename SampleType>
+struct ScalarVector
+{
+    using Mask = bool;
+    using Bits = std::conditional_t<sizeof (SampleType) == 4, uint32_t, uint64_t>;
+
+    static constexpr int size = 1;
+    static constexpr int mantissaBits = std::numeric_limits<SampleType>::digits - 1;
+    static constexpr int exponentBias = std::numeric_limits<SampleType>::max_exponent - 1;
+
+    SampleType value;
+
+    static ScalarVector load (const SampleType* p) noexcept     { return { *p }; }
+    static ScalarVector broadcast (SampleType x) noexcept       { return { x }; }
+    void store (SampleType* p) const noexcept                   { *p = value; }
+
+    friend ScalarVector operator+ (ScalarVector a, ScalarVector b) noexcept { return { a.value + b.value }; }
+    friend ScalarVector operator- (ScalarVector a, ScalarVector b) noexcept { return { a.value - b.value }; }
+    friend ScalarVector operator* (ScalarVector a, ScalarVector b) noexcept { return { a.value * b.value }; }
+    friend ScalarVector operator/ (ScalarVector a, ScalarVector b) noexcept { return { a.value / b.value }; }
+
+    // Same operand order as minps/maxps, so NaN handling matches the vector paths
+    static ScalarVector min (ScalarVector a, ScalarVector b) noexcept   { return { a.value < b.value ? a.value : b.value }; }
+    static ScalarVector max (ScalarVector a, ScalarVector b) noexcept   { return { a.value > b.value ? a.value : b.value }; }
+    static ScalarVector abs (ScalarVector a) noexcept                   { return { std::abs (a.value) }; }
+    static ScalarVector sqrt (ScalarVector a) noexcept                  { return { std::sqrt (a.value) }; }
+
+    static Mask lessThan (ScalarVector a, ScalarVector b) noexcept      { return a.value < b.value; }
+    static ScalarVector select (Mask m, ScalarVector a, ScalarVector b) noexcept    { return m ? a : b; }
+
+    static ScalarVector truncate (ScalarVector a) noexcept              { return { (SampleType) (int32_t) a.value }; }
+    static ScalarVector gather (const SampleType* table, ScalarVector index) noexcept   { return { table[(int32_t) index.value] }; }
+
+    /** The unbiased binary exponent of a positive value, as a whole number. */
+    static ScalarVector getExponent (ScalarVector a) noexcept
+    {
+        return { (SampleType) (int32_t) (toBits (a.value) >> mantissaBits) - (SampleType) exponentBias };
+    }
+
+    /** The mantissa of a positive value, scaled into [1, 2). */
+    static ScalarVector getMantissa (ScalarVector a) noexcept
+    {
+        const auto mantissaMask = ((Bits) 1 << mantissaBits) - 1;
+        return { fromBits ((toBits (a.value) & mantissaMask) | toBits ((SampleType) 1)) };
+    }
+
+    /** 2^n for a whole number n within the normal exponent range. */
+    static ScalarVector powerOfTwo (ScalarVector n) noexcept
+    {
+        return { fromBits ((Bits) ((int32_t) n.value + exponentBias) << mantissaBits) };
+    }
+
+private:
+    static Bits toBits (SampleType x) noexcept              { Bits b; std::memcpy (&b, &x, sizeof (b)); return b; }
+    static SampleType fromBits (Bits b) noexcept            { SampleType x; std::memcpy (&x, &b, sizeof (x)); return x; }
+};
+
+//==============================================================================
+#if VOCALCOMPRESSOR_SIMD_AVX
+
+struct FloatVectorAVX
+{
+    using Mask = __m256;
+    static constexpr int size = 8;
+
+    __m256 value;
+
+    static FloatVectorAVX load (const float* p) noexcept        { return { _mm256_loadu_ps (p) }; }
+    static FloatVectorAVX broadcast (float x) noexcept          { return { _mm256_set1_ps (x) }; }
+    void store (float* p) const noexcept                        { _mm256_storeu_ps (p, value); }
+
+    friend FloatVectorAVX operator+ (FloatVectorAVX a, FloatVectorAVX b) noexcept   { return { _mm256_add_ps (a.value, b.value) }; }
+    friend FloatVectorAVX operator- (FloatVectorAVX a, FloatVectorAVX b) noexcept   { return { _mm256_sub_ps (a.value, b.value) }; }
+    friend FloatVectorAVX operator* (FloatVectorAVX a, FloatVectorAVX b) noexcept   { return { _mm256_mul_ps (a.value, b.value) }; }
+    friend FloatVectorAVX operator/ (FloatVectorAVX a, FloatVectorAVX b) noexcept   { return { _mm256_div_ps (a.value, b.value) }; }
+
+    static FloatVectorAVX min (FloatVectorAVX a, FloatVectorAVX b) noexcept { return { _mm256_min_ps (a.value, b.value) }; }
+    static FloatVectorAVX max (FloatVectorAVX a, FloatVectorAVX b) noexcept { return { _mm256_max_ps (a.value, b.value) }; }
+    static FloatVectorAVX abs (FloatVectorAVX a) noexcept                   { return { _mm256_andnot_ps (_mm256_set1_ps (-0.0f), a.value) }; }
+    static FloatVectorAVX sqrt (FloatVectorAVX a) noexcept                  { return { _mm256_sqrt_ps (a.value) }; }
+
+    static Mask lessThan (FloatVectorAVX a, FloatVectorAVX b) noexcept      { return _mm256_cmp_ps (a.value, b.value, _CMP_LT_OQ); }
+    static FloatVectorAVX select (Mask m, FloatVectorAVX a, FloatVectorAVX b) noexcept  { return { _mm256_blendv_ps (b.value, a.value, m) }; }
+
+    static FloatVectorAVX truncate (FloatVectorAVX a) noexcept  { return { _mm256_round_ps (a.value, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC) }; }
+
+    static FloatVectorAVX gather (const float* table, FloatVectorAVX index) noexcept
+    {
+        return { _mm256_i32gather_ps (table, _mm256_cvttps_epi32 (index.value), 4) };
+    }
+
+    static FloatVectorAVX getExponent (FloatVectorAVX a) noexcept
+    {
+        const auto exponent = _mm256_srli_epi32 (_mm256_castps_si256 (a.value), 23);
+        return { _mm256_cvtepi32_ps (_mm256_sub_epi32 (exponent, _mm256_set1_epi32 (127))) };
+    }
+
+    static FloatVectorAVX getMantissa (FloatVectorAVX a) noexcept
+    {
+        const auto mantissa = _mm256_and_si256 (_mm256_castps_si256 (a.value), _mm256_set1_epi32 (0x007fffff));
+        return { _mm256_castsi256_ps (_mm256_or_si256 (mantissa, _mm256_set1_epi32 (0x3f800000))) };
+    }
+
+    static FloatVectorAVX powerOfTwo (FloatVectorAVX n) noexcept
+    {
+        const auto exponent = _mm256_add_epi32 (_mm256_cvttps_epi32 (n.value), _mm256_set1_epi32 (127));
+        return { _mm256_castsi256_ps (_mm256_slli_epi32 (exponent, 23)) };
+    }
+};
+
+//==============================================================================
+struct DoubleVectorAVX
+{
+    using Mask = __m256d;
+    static constexpr int size = 4;
+
+    __m256d value;
+
+    static DoubleVectorAVX load (const double* p) noexcept      { return { _mm256_loadu_pd (p) }; }
+    static DoubleVectorAVX broadcast (double x) noexcept        { return { _mm256_set1_pd (x) }; }
+    void store (double* p) const noexcept                       { _mm256_storeu_pd (p, value); }
+
+    friend DoubleVectorAVX operator+ (DoubleVectorAVX a, DoubleVectorAVX b) noexcept    { return { _mm256_add_pd (a.value, b.value) }; }
+    friend DoubleVectorAVX operator- (DoubleVectorAVX a, DoubleVectorAVX b) noexcept    { return { _mm256_sub_pd (a.value, b.value) }; }
+    friend DoubleVectorAVX operator* (DoubleVectorAVX a, DoubleVectorAVX b) noexcept    { return { _mm256_mul_pd (a.value, b.value) }; }
+    friend DoubleVectorAVX operator/ (DoubleVectorAVX a, DoubleVectorAVX b) noexcept    { return { _mm256_div_pd (a.value, b.value) }; }
+
+    static DoubleVectorAVX min (DoubleVectorAVX a, DoubleVectorAVX b) noexcept  { return { _mm256_min_pd (a.value, b.value) }; }
+    static DoubleVectorAVX max (DoubleVectorAVX a, DoubleVectorAVX b) noexcept  { return { _mm256_max_pd (a.value, b.value) }; }
+    static DoubleVectorAVX abs (DoubleVectorAVX a) noexcept                     { return { _mm256_andnot_pd (_mm256_set1_pd (-0.0), a.value) }; }
+    static DoubleVectorAVX sqrt (DoubleVectorAVX a) noexcept                    { return { _mm256_sqrt_pd (a.value) }; }
+
+    static Mask lessThan (DoubleVectorAVX a, DoubleVectorAVX b) noexcept        { return _mm256_cmp_pd (a.value, b.value, _CMP_LT_OQ); }
+    static DoubleVectorAVX select (Mask m, DoubleVectorAVX a, DoubleVectorAVX b) noexcept   { return { _mm256_blendv_pd (b.value, a.value, m) }; }
+
+    static DoubleVectorAVX truncate (DoubleVectorAVX a) noexcept    { return { _mm256_round_pd (a.value, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC) }; }
+
+    static DoubleVectorAVX gather (const double* table, DoubleVectorAVX index) noexcept
+    {
+        // The masked form, since GCC warns about the undefined source of the plain one
+        const auto all = _mm256_castsi256_pd (_mm256_set1_epi64x (-1));
+        return { _mm256_mask_i32gather_pd (_mm256_setzero_pd(), table, _mm256_cvttpd_epi32 (index.value), all, 8) };
+    }
+
+    // The 64 bit integer conversions go through the bits of 2^52 + n
+    static DoubleVectorAVX getExponent (DoubleVectorAVX a) noexcept
+    {
+        const auto exponent = _mm256_srli_epi64 (_mm256_castpd_si256 (a.value), 52);
+        const auto biased = _mm256_or_si256 (exponent, _mm256_set1_epi64x (0x4330000000000000));
+        return { _mm256_sub_pd (_mm256_castsi256_pd (biased), _mm256_set1_pd (4503599627370496.0 + 1023.0)) };
+    }
+
+    static DoubleVectorAVX getMantissa (DoubleVectorAVX a) noexcept
+    {
+        const auto mantissa = _mm256_and_si256 (_mm256_castpd_si256 (a.value), _mm256_set1_epi64x (0x000fffffffffffff));
+        return { _mm256_castsi256_pd (_mm256_or_si256 (mantissa, _mm256_set1_epi64x (0x3ff0000000000000))) };
+    }
+
+    static DoubleVectorAVX powerOfTwo (DoubleVectorAVX n) noexcept
+    {
+        const auto biased = _mm256_add_pd (n.value, _mm256_set1_pd (4503599627370496.0 + 1023.0));
+        return { _mm256_castsi256_pd (_mm256_slli_epi64 (_mm256_castpd_si256 (biased), 52)) };
+    }
+};
+
+#endif
+
+//==============================================================================
+#if VOCALCOMPRESSOR_SIMD_AVX || VOCALCOMPRESSOR_SIMD_SSE
+
+struct FloatVectorSSE
+{
+    using Mask = __m128;
+    static constexpr int size = 4;
+
+    __m128 value;
+
+    static FloatVectorSSE load (const float* p) noexcept        { return { _mm_loadu_ps (p) }; }
+    static FloatVectorSSE broadcast (float x) noexcept          { return { _mm_set1_ps (x) }; }
+    void store (float* p) const noexcept                        { _mm_storeu_ps (p, value); }
+
+    friend FloatVectorSSE operator+ (FloatVectorSSE a, FloatVectorSSE b) noexcept   { return { _mm_add_ps (a.value, b.value) }; }
+    friend FloatVectorSSE operator- (FloatVectorSSE a, FloatVectorSSE b) noexcept   { return { _mm_sub_ps (a.value, b.value) }; }
+    friend FloatVectorSSE operator* (FloatVectorSSE a, FloatVectorSSE b) noexcept   { return { _mm_mul_ps (a.value, b.value) }; }
+    friend FloatVectorSSE operator/ (FloatVectorSSE a, FloatVectorSSE b) noexcept   { return { _mm_div_ps (a.value, b.value) }; }
+
+    static FloatVectorSSE min (FloatVectorSSE a, FloatVectorSSE b) noexcept { return { _mm_min_ps (a.value, b.value) }; }
+    static FloatVectorSSE max (FloatVectorSSE a, FloatVectorSSE b) noexcept { return { _mm_max_ps (a.value, b.value) }; }
+    static FloatVectorSSE abs (FloatVectorSSE a) noexcept                   { return { _mm_andnot_ps (_mm_set1_ps (-0.0f), a.value) }; }
+    static FloatVectorSSE sqrt (FloatVectorSSE a) noexcept                  { return { _mm_sqrt_ps (a.value) }; }
+
+    static Mask lessThan (FloatVectorSSE a, FloatVectorSSE b) noexcept      { return _mm_cmplt_ps (a.value, b.value); }
+    static FloatVectorSSE select (Mask m, FloatVectorSSE a, FloatVectorSSE b) noexcept
+    {
+        return { _mm_or_ps (_mm_and_ps (m, a.value), _mm_andnot_ps (m, b.value)) };
+    }
+
+    static FloatVectorSSE truncate (FloatVectorSSE a) noexcept  { return { _mm_cvtepi32_ps (_mm_cvttps_epi32 (a.value)) }; }
+
+    static FloatVectorSSE gather (const float* table, FloatVectorSSE index) noexcept
+    {
+        alignas (16) int32_t i[4];
+        _mm_store_si128 ((__m128i*) i, _mm_cvttps_epi32 (index.value));
+        return { _mm_setr_ps (table[i[0]], table[i[1]], table[i[2]], table[i[3]]) };
+    }
+
+    static FloatVectorSSE getExponent (FloatVectorSSE a) noexcept
+    {
+        const auto exponent = _mm_srli_epi32 (_mm_castps_si128 (a.value), 23);
+        return { _mm_cvtepi32_ps (_mm_sub_epi32 (exponent, _mm_set1_epi32 (127))) };
+    }
+
+    static FloatVectorSSE getMantissa (FloatVectorSSE a) noexcept
+    {
+        const auto mantissa = _mm_and_si128 (_mm_castps_si128 (a.value), _mm_set1_epi32 (0x007fffff));
+        return { _mm_castsi128_ps (_mm_or_si128 (mantissa, _mm_set1_epi32 (0x3f800000))) };
+    }
+
+    static FloatVectorSSE powerOfTwo (FloatVectorSSE n) noexcept
+    {
+        const auto exponent = _mm_add_epi32 (_mm_cvttps_epi32 (n.value), _mm_set1_epi32 (127));
+        return { _mm_castsi128_ps (_mm_slli_epi32 (exponent, 23)) };
+    }
+};
+
+//==============================================================================
+struct DoubleVectorSSE
+{
+    using Mask = __m128d;
+    static constexpr int size = 2;
+
+    __m128d value;
+
+    static DoubleVectorSSE load (const double* p) noexcept      { return { _mm_loadu_pd (p) }; }
+    static DoubleVectorSSE broadcast (double x) noexcept        { return { _mm_set1_pd (x) }; }
+    void store (double* p) const noexcept                       { _mm_storeu_pd (p, value); }
+
+    friend DoubleVectorSSE operator+ (DoubleVectorSSE a, DoubleVectorSSE b) noexcept    { return { _mm_add_pd (a.value, b.value) }; }
+    friend DoubleVectorSSE operator- (DoubleVectorSSE a, DoubleVectorSSE b) noexcept    { return { _mm_sub_pd (a.value, b.value) }; }
+    friend DoubleVectorSSE operator* (DoubleVectorSSE a, DoubleVectorSSE b) noexcept    { return { _mm_mul_pd (a.value, b.value) }; }
+    friend DoubleVectorSSE operator/ (DoubleVectorSSE a, DoubleVectorSSE b) noexcept    { return { _mm_div_pd (a.value, b.value) }; }
+
+    static DoubleVectorSSE min (DoubleVectorSSE a, DoubleVectorSSE b) noexcept  { return { _mm_min_pd (a.value, b.value) }; }
+    static DoubleVectorSSE max (DoubleVectorSSE a, DoubleVectorSSE b) noexcept  { return { _mm_max_pd (a.value, b.value) }; }
+    static DoubleVectorSSE abs (DoubleVectorSSE a) noexcept                     { return { _mm_andnot_pd (_mm_set1_pd (-0.0), a.value) }; }
+    static DoubleVectorSSE sqrt (DoubleVectorSSE a) noexcept                    { return { _mm_sqrt_pd (a.value) }; }
+
+    static Mask lessThan (DoubleVectorSSE a, DoubleVectorSSE b) noexcept        { return _mm_cmplt_pd (a.value, b.value); }
+    static DoubleVectorSSE select (Mask m, DoubleVectorSSE a, DoubleVectorSSE b) noexcept
+    {
+        return { _mm_or_pd (_mm_and_pd (m, a.value), _mm_andnot_pd (m, b.value)) };
+    }
+
+    static DoubleVectorSSE truncate (DoubleVectorSSE a) noexcept    { return { _mm_cvtepi32_pd (_mm_cvttpd_epi32 (a.value)) }; }
+
+    static DoubleVectorSSE gather (const double* table, DoubleVectorSSE index) noexcept
+    {
+        alignas (16) int32_t i[4];
+        _mm_store_si128 ((__m128i*) i, _mm_cvttpd_epi32 (index.value));
+        return { _mm_setr_pd (table[i[0]], table[i[1]]) };
+    }
+
+    // The 64 bit integer conversions go through the bits of 2^52 + n
+    static DoubleVectorSSE getExponent (DoubleVectorSSE a) noexcept
+    {
+        const auto exponent = _mm_srli_epi64 (_mm_castpd_si128 (a.value), 52);
+        const auto biased = _mm_or_si128 (exponent, _mm_set1_epi64x (0x4330000000000000));
+        return { _mm_sub_pd (_mm_castsi128_pd (biased), _mm_set1_pd (4503599627370496.0 + 1023.0)) };
+    }
+
+    static DoubleVectorSSE getMantissa (DoubleVectorSSE a) noexcept
+    {
+        const auto mantissa = _mm_and_si128 (_mm_castpd_si128 (a.value), _mm_set1_epi64x (0x000fffffffffffff));
+        return { _mm_castsi128_pd (_mm_or_si128 (mantissa, _mm_set1_epi64x (0x3ff0000000000000))) };
+    }
+
+    static DoubleVectorSSE powerOfTwo (DoubleVectorSSE n) noexcept
+    {
+        const auto biased = _mm_add_pd (n.value, _mm_set1_pd (4503599627370496.0 + 1023.0));
+        return { _mm_castsi128_pd (_mm_slli_epi64 (_mm_castpd_si128 (biased), 52)) };
+    }
+};
+
+//==============================================================================
+#elif VOCALCOMPRESSOR_SIMD_NEON
+
+struct FloatVectorNEON
+{
+    using Mask = uint32x4_t;
+    static constexpr int size = 4;
+
+    float32x4_t value;
+
+    static FloatVectorNEON load (const float* p) noexcept       { return { vld1q_f32 (p) }; }
+    static FloatVectorNEON broadcast (float x) noexcept         { return { vdupq_n_f32 (x) }; }
+    void store (float* p) const noexcept                        { vst1q_f32 (p, value); }
+
+    friend FloatVectorNEON operator+ (FloatVectorNEON a, FloatVectorNEON b) noexcept    { return { vaddq_f32 (a.value, b.value) }; }
+    friend FloatVectorNEON operator- (FloatVectorNEON a, FloatVectorNEON b) noexcept    { return { vsubq_f32 (a.value, b.value) }; }
+    friend FloatVectorNEON operator* (FloatVectorNEON a, FloatVectorNEON b) noexcept    { return { vmulq_f32 (a.value, b.value) }; }
+
+    friend FloatVectorNEON operator/ (FloatVectorNEON a, FloatVectorNEON b) noexcept
+    {
+       #if defined (__aarch64__) || defined (_M_ARM64)
+        return { vdivq_f32 (a.value, b.value) };
+       #else
+        float x[4], y[4];
+        vst1q_f32 (x, a.value);
+        vst1q_f32 (y, b.value);
+
+        for (int i = 0; i < 4; ++i)
+            x[i] /= y[i];
+
+        return { vld1q_f32 (x) };
+       #endif
+    }
+
+    static FloatVectorNEON min (FloatVectorNEON a, FloatVectorNEON b) noexcept  { return { vminq_f32 (a.value, b.value) }; }
+    static FloatVectorNEON max (FloatVectorNEON a, FloatVectorNEON b) noexcept  { return { vmaxq_f32 (a.value, b.value) }; }
+    static FloatVectorNEON abs (FloatVectorNEON a) noexcept                     { return { vabsq_f32 (a.value) }; }
+
+    static FloatVectorNEON sqrt (FloatVectorNEON a) noexcept
+    {
+       #if defined (__aarch64__) || defined (_M_ARM64)
+        return { vsqrtq_f32 (a.value) };
+       #else
+        float x[4];
+        vst1q_f32 (x, a.value);
+
+        for (auto& lane : x)
+            lane = std::sqrt (lane);
+
+        return { vld1q_f32 (x) };
+       #endif
+    }
+
+    static Mask lessThan (FloatVectorNEON a, FloatVectorNEON b) noexcept        { return vcltq_f32 (a.value, b.value); }
+    static FloatVectorNEON select (Mask m, FloatVectorNEON a, FloatVectorNEON b) noexcept   { return { vbslq_f32 (m, a.value, b.value) }; }
+
+    static FloatVectorNEON truncate (FloatVectorNEON a) noexcept    { return { vcvtq_f32_s32 (vcvtq_s32_f32 (a.value)) }; }
+
+    static FloatVectorNEON gather (const float* table, FloatVectorNEON index) noexcept
+    {
+        int32_t i[4];
+        vst1q_s32 (i, vcvtq_s32_f32 (index.value));
+        const float values[4] = { table[i[0]], table[i[1]], table[i[2]], table[i[3]] };
+        return { vld1q_f32 (values) };
+    }
+
+    static FloatVectorNEON getExponent (FloatVectorNEON a) noexcept
+    {
+        const auto exponent = vshrq_n_u32 (vreinterpretq_u32_f32 (a.value), 23);
+        return { vcvtq_f32_s32 (vsubq_s32 (vreinterpretq_s32_u32 (exponent), vdupq_n_s32 (127))) };
+    }
+
+    static FloatVectorNEON getMantissa (FloatVectorNEON a) noexcept
+    {
+        const auto mantissa = vandq_u32 (vreinterpretq_u32_f32 (a.value), vdupq_n_u32 (0x007fffff));
+        return { vreinterpretq_f32_u32 (vorrq_u32 (mantissa, vdupq_n_u32 (0x3f800000))) };
+    }
+
+    static FloatVectorNEON powerOfTwo (FloatVectorNEON n) noexcept
+    {
+        const auto exponent = vaddq_s32 (vcvtq_s32_f32 (n.value), vdupq_n_s32 (127));
+        return { vreinterpretq_f32_s32 (vshlq_n_s32 (exponent, 23)) };
+    }
+};
+
+//==============================================================================
+#if defined (__aarch64__) || defined (_M_ARM64)
+ #define VOCALCOMPRESSOR_SIMD_NEON_DOUBLE 1
+
+struct DoubleVectorNEON
+{
+    using Mask = uint64x2_t;
+    static constexpr int size = 2;
+
+    float64x2_t value;
+
+    static DoubleVectorNEON load (const double* p) noexcept     { return { vld1q_f64 (p) }; }
+    static DoubleVectorNEON broadcast (double x) noexcept       { return { vdupq_n_f64 (x) }; }
+    void store (double* p) const noexcept                       { vst1q_f64 (p, value); }
+
+    friend DoubleVectorNEON operator+ (DoubleVectorNEON a, DoubleVectorNEON b) noexcept { return { vaddq_f64 (a.value, b.value) }; }
+    friend DoubleVectorNEON operator- (DoubleVectorNEON a, DoubleVectorNEON b) noexcept { return { vsubq_f64 (a.value, b.value) }; }
+    friend DoubleVectorNEON operator* (DoubleVectorNEON a, DoubleVectorNEON b) noexcept { return { vmulq_f64 (a.value, b.value) }; }
+    friend DoubleVectorNEON operator/ (DoubleVectorNEON a, DoubleVectorNEON b) noexcept { return { vdivq_f64 (a.value, b.value) }; }
+
+    static DoubleVectorNEON min (DoubleVectorNEON a, DoubleVectorNEON b) noexcept   { return { vminq_f64 (a.value, b.value) }; }
+    static DoubleVectorNEON max (DoubleVectorNEON a, DoubleVectorNEON b) noexcept   { return { vmaxq_f64 (a.value, b.value) }; }
+    static DoubleVectorNEON abs (DoubleVectorNEON a) noexcept                       { return { vabsq_f64 (a.value) }; }
+    static DoubleVectorNEON sqrt (DoubleVectorNEON a) noexcept                      { return { vsqrtq_f64 (a.value) }; }
+
+    static Mask lessThan (DoubleVectorNEON a, DoubleVectorNEON b) noexcept          { return vcltq_f64 (a.value, b.value); }
+    static DoubleVectorNEON select (Mask m, DoubleVectorNEON a, DoubleVectorNEON b) noexcept    { return { vbslq_f64 (m, a.value, b.value) }; }
+
+    static DoubleVectorNEON truncate (DoubleVectorNEON a) noexcept  { return { vrndq_f64 (a.value) }; }
+
+    static DoubleVectorNEON gather (const double* table, DoubleVectorNEON index) noexcept
+    {
+        int64_t i[2];
+        vst1q_s64 (i, vcvtq_s64_f64 (index.value));
+        const double values[2] = { table[i[0]], table[i[1]] };
+        return { vld1q_f64 (values) };
+    }
+
+    static DoubleVectorNEON getExponent (DoubleVectorNEON a) noexcept
+    {
+        const auto exponent = vshrq_n_u64 (vreinterpretq_u64_f64 (a.value), 52);
+        return { vsubq_f64 (vcvtq_f64_u64 (exponent), vdupq_n_f64 (1023.0)) };
+    }
+
+    static DoubleVectorNEON getMantissa (DoubleVectorNEON a) noexcept
+    {
+        const auto mantissa = vandq_u64 (vreinterpretq_u64_f64 (a.value), vdupq_n_u64 (0x000fffffffffffff));
+        return { vreinterpretq_f64_u64 (vorrq_u64 (mantissa, vdupq_n_u64 (0x3ff0000000000000))) };
+    }
+
+    static DoubleVectorNEON powerOfTwo (DoubleVectorNEON n) noexcept
+    {
+        const auto exponent = vaddq_s64 (vcvtq_s64_f64 (n.value), vdupq_n_s64 (1023));
+        return { vreinterpretq_f64_s64 (vshlq_n_s64 (exponent, 52)) };
+    }
+};
+
+#endif
+
+#endif
+
+//==============================================================================
+/** Picks the widest vector type available for a sample type. */
+template <typename SampleType>
+struct NativeVector
+{
+    using Type = ScalarVector<SampleType>;
+};
+
+#if VOCALCOMPRESSOR_SIMD_AVX
+template <> struct NativeVector<float>  { using Type = FloatVectorAVX; };
+template <> struct NativeVector<double> { using Type = DoubleVectorAVX; };
+#elif VOCALCOMPRESSOR_SIMD_SSE
+template <> struct NativeVector<float>  { using Type = FloatVectorSSE; };
+template <> struct NativeVector<double> { using Type = DoubleVectorSSE; };
+#elif VOCALCOMPRESSOR_SIMD_NEON
+template <> struct NativeVector<float>  { using Type = FloatVectorNEON; };
+ #if VOCALCOMPRESSOR_SIMD_NEON_DOUBLE
+template <> struct NativeVector<double> { using Type = DoubleVectorNEON; };
+ #endif
+#endif
+
+template <typename SampleType>
+using SIMDVector = typename NativeVector<SampleType>::Type;
+
+/** Half the native width where the instruction set has it, otherwise the
+    native vector.
+*/
+template <typename SampleType>
+struct NarrowVector
+{
+    using Type = SIMDVector<SampleType>;
+};
+
+#if VOCALCOMPRESSOR_SIMD_AVX
+template <> struct NarrowVector<float>  { using Type = FloatVectorSSE; };
+template <> struct NarrowVector<double> { using Type = DoubleVectorSSE; };
+#endif
+
+template <typename SampleType>
+using NarrowSIMDVector = typename NarrowVector<SampleType>::Type;
+
+/** The instruction set the vector paths were compiled for. */
+inline const char* getSIMDInstructionSet() noexcept
+{
+   #if VOCALCOMPRESSOR_SIMD_AVX
+    return "AVX2";
+   #elif VOCALCOMPRESSOR_SIMD_SSE
+    return "SSE2";
+   #elif VOCALCOMPRESSOR_SIMD_NEON
+    return "NEON";
+   #else
+    return "Scalar";
+   #endif
+}
+
+} // namespace VocalDSP
@@ -0,0 +1,93 @@
+/*
+  ==============================================================================
+
+    GainReductionHistory.cpp
+
+  ==============================================================================
+*/
+
+#include "GainReductionHistory.h"
+
+namespace
+{
+    constexpr float rangeDb = 24.0f;
+    constexpr float gridDb = 6.0f;
+}
+
+//==============================================================================
+GainReductionHistory::GainReductionHistory (juce::Colour reduction, juce::Colour grid,
+                                            juce::Colour background)
+    : reductionColour (reduction), gridColour (grid), backgroundColour (background)
+{
+    setOpaque (true);
+}
+
+void GainReductionHistory::update (const MeterFrame* frames, int numFrames)
+{
+    if (! image.isValid())
+        return;
+
+    float reductionDb = 0.0f;
+
+    for (int i = 0; i < numFrames; ++i)
+        reductionDb = juce::jmin (reductionDb, frames[i].gainReductionDb);
+
+    drawColumn (writePosition, reductionDb);
+    writePosition = (writePosition + 1) % image.getWidth();
+
+    repaint();
+}
+
+//==============================================================================
+void GainReductionHistory::paint (juce::Graphics& g)
+{
+    if (! image.isValid())
+    {
+        g.fillAll (backgroundColour);
+        return;
+    }
+
+    // The column at writePosition is the oldest
+    const int width = image.getWidth();
+    const int height = image.getHeight();
+    const int older = width - writePosition;
+
+    g.drawImage (image, 0, 0, older, height, writePosition, 0, older, height);
+
+    if (writePosition > 0)
+        g.drawImage (image, older, 0, writePosition, height, 0, 0, writePosition, height);
+}
+
+void GainReductionHistory::resized()
+{
+    if (getWidth() <= 0 || getHeight() <= 0)
+    {
+        image = {};
+        return;
+    }
+
+    image = juce::Image (juce::Image::RGB, getWidth(), getHeight(), false);
+    writePosition = 0;
+
+    for (int x = 0; x < image.getWidth(); ++x)
+        drawColumn (x, 0.0f);
+}
+
+void GainReductionHistory::drawColumn (int x, float reductionDb)
+{
+    juce::Graphics g (image);
+    g.reduceClipRegion (x, 0, 1, image.getHeight());
+    g.fillAll (backgroundColour);
+
+    const auto yScale = (float) image.getHeight() / rangeDb;
+
+    // Hangs down from the top, like the meter
+    const auto depth = juce::jlimit (0.0f, rangeDb, -reductionDb) * yScale;
+    g.setColour (reductionColour);
+    g.fillRect ((float) x, 0.0f, 1.0f, depth);
+
+    g.setColour (gridColour);
+
+    for (float decibels = gridDb; decibels < rangeDb; decibels += gridDb)
+        g.fillRect (x, juce::roundToInt (decibels * yScale), 1, 1);
+}
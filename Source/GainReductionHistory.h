@@ -0,0 +1,42 @@
+/*
+  ==============================================================================
+
+    GainReductionHistory.h
+
+    A scrolling view of the gain reduction, one column per update(). The
+    columns are kept in an image used as a ring buffer: each update() draws
+    only the new column into it, and paint() blits the image in two pieces
+    so the oldest column is on the left.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "MeterFeed.h"
+
+//==============================================================================
+class GainReductionHistory  : public juce::Component
+{
+public:
+    GainReductionHistory (juce::Colour reductionColour, juce::Colour gridColour,
+                          juce::Colour backgroundColour);
+
+    /** Adds a column for the largest gain reduction among the frames. */
+    void update (const MeterFrame* frames, int numFrames);
+
+    //==============================================================================
+    void paint (juce::Graphics&) override;
+    void resized() override;
+
+private:
+    void drawColumn (int x, float reductionDb);
+
+    const juce::Colour reductionColour, gridColour, backgroundColour;
+
+    juce::Image image;
+    int writePosition = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (GainReductionHistory)
+};
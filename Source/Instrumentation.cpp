@@ -0,0 +1,329 @@
+/*
+  ==============================================================================
+
+    Instrumentation.cpp
+
+  ==============================================================================
+*/
+
+#include "Instrumentation.h"
+
+#include <cmath>
+
+namespace
+{
+    // The block being timed on this thread. A plain pointer, so reading it
+    // from the hooks below neither allocates nor locks.
+    thread_local Instrumentation* currentBlock = nullptr;
+}
+
+//==============================================================================
+double Instrumentation::getBinEdge (int bin) noexcept
+{
+    if (bin >= numBins - 1)
+        return std::numeric_limits<double>::infinity();
+
+    return lowestMicroseconds * std::exp2 ((double) bin / binsPerOctave);
+}
+
+double Instrumentation::Snapshot::getPercentile (double fraction) const noexcept
+{
+    const auto target = (juce::int64) std::ceil (juce::jlimit (0.0, 1.0, fraction) * (double) numBlocks);
+    juce::int64 count = 0;
+
+    for (int bin = 0; bin < numBins; ++bin)
+    {
+        count += histogram[(size_t) bin];
+
+        if (count >= target && count > 0)
+            return juce::jmin (getBinEdge (bin), maximumMicroseconds);
+    }
+
+    return maximumMicroseconds;
+}
+
+juce::var Instrumentation::Snapshot::toVar() const
+{
+    juce::Array<juce::var> bins;
+
+    for (auto count : histogram)
+        bins.add (count);
+
+    auto* result = new juce::DynamicObject();
+    result->setProperty ("version", 1);
+    result->setProperty ("sampleRate", sampleRate);
+    result->setProperty ("blocks", numBlocks);
+    result->setProperty ("overruns", numOverruns);
+    result->setProperty ("allocations", numAllocations);
+    result->setProperty ("deallocations", numDeallocations);
+    result->setProperty ("locks", numLocks);
+    result->setProperty ("totalMicroseconds", totalMicroseconds);
+    result->setProperty ("maximumMicroseconds", maximumMicroseconds);
+    result->setProperty ("maximumLoad", maximumLoad);
+    result->setProperty ("binsPerOctave", binsPerOctave);
+    result->setProperty ("lowestMicroseconds", lowestMicroseconds);
+    result->setProperty ("histogram", bins);
+    return juce::var (result);
+}
+
+bool Instrumentation::Snapshot::fromVar (const juce::var& dump, Snapshot& result)
+{
+    const auto* bins = dump["histogram"].getArray();
+
+    if (bins == nullptr || bins->size() != numBins
+         || (int) dump["binsPerOctave"] != binsPerOctave
+         || (double) dump["lowestMicroseconds"] != lowestMicroseconds)
+        return false;
+
+    result.sampleRate = dump["sampleRate"];
+    result.numBlocks = dump["blocks"];
+    result.numOverruns = dump["overruns"];
+    result.numAllocations = dump["allocations"];
+    result.numDeallocations = dump["deallocations"];
+    result.numLocks = dump["locks"];
+    result.totalMicroseconds = dump["totalMicroseconds"];
+    result.maximumMicroseconds = dump["maximumMicroseconds"];
+    result.maximumLoad = dump["maximumLoad"];
+
+    for (int bin = 0; bin < numBins; ++bin)
+        result.histogram[(size_t) bin] = (*bins)[bin];
+
+    return true;
+}
+
+//==============================================================================
+void Instrumentation::prepare (double newSampleRate) noexcept
+{
+    sampleRate.store (newSampleRate, std::memory_order_relaxed);
+    reset();
+}
+
+void Instrumentation::clear() noexcept
+{
+    for (auto* counter : { &numBlocks, &numOverruns, &numAllocations, &numDeallocations,
+                           &numLocks, &totalTicks, &maximumTicks })
+        counter->store (0, std::memory_order_relaxed);
+
+    for (auto& count : histogram)
+        count.store (0, std::memory_order_relaxed);
+
+    maximumLoad.store (0.0, std::memory_order_relaxed);
+}
+
+Instrumentation::Snapshot Instrumentation::getSnapshot() const noexcept
+{
+    const auto ticksPerMicrosecond = (double) juce::Time::getHighResolutionTicksPerSecond() / 1.0e6;
+
+    Snapshot snapshot;
+    snapshot.sampleRate = sampleRate.load (std::memory_order_relaxed);
+    snapshot.numBlocks = numBlocks.load (std::memory_order_relaxed);
+    snapshot.numOverruns = numOverruns.load (std::memory_order_relaxed);
+    snapshot.numAllocations = numAllocations.load (std::memory_order_relaxed);
+    snapshot.numDeallocations = numDeallocations.load (std::memory_order_relaxed);
+    snapshot.numLocks = numLocks.load (std::memory_order_relaxed);
+    snapshot.totalMicroseconds = (double) totalTicks.load (std::memory_order_relaxed) / ticksPerMicrosecond;
+    snapshot.maximumMicroseconds = (double) maximumTicks.load (std::memory_order_relaxed) / ticksPerMicrosecond;
+    snapshot.maximumLoad = maximumLoad.load (std::memory_order_relaxed);
+
+    for (int bin = 0; bin < numBins; ++bin)
+        snapshot.histogram[(size_t) bin] = histogram[(size_t) bin].load (std::memory_order_relaxed);
+
+    return snapshot;
+}
+
+//==============================================================================
+Instrumentation::ScopedBlock::ScopedBlock (Instrumentation& instrumentation, int samples) noexcept
+    : owner (instrumentation), previous (currentBlock), numSamples (samples),
+      startTicks (juce::Time::getHighResolutionTicks())
+{
+    if (owner.resetRequested.exchange (false, std::memory_order_relaxed))
+        owner.clear();
+
+    currentBlock = &owner;
+}
+
+Instrumentation::ScopedBlock::~ScopedBlock() noexcept
+{
+    currentBlock = previous;
+    owner.addBlock (juce::Time::getHighResolutionTicks() - startTicks, numSamples);
+}
+
+void Instrumentation::addBlock (juce::int64 ticks, int numSamples) noexcept
+{
+    const auto ticksPerSecond = (double) juce::Time::getHighResolutionTicksPerSecond();
+    const auto microseconds = (double) ticks * 1.0e6 / ticksPerSecond;
+
+    // Bin 0 holds everything up to lowestMicroseconds
+    const auto bin = microseconds <= lowestMicroseconds
+                       ? 0
+                       : juce::jmin (numBins - 1, 1 + (int) (std::log2 (microseconds / lowestMicroseconds) * binsPerOctave));
+
+    increment (histogram[(size_t) bin]);
+    increment (numBlocks);
+    totalTicks.store (totalTicks.load (std::memory_order_relaxed) + ticks, std::memory_order_relaxed);
+
+    if (ticks > maximumTicks.load (std::memory_order_relaxed))
+        maximumTicks.store (ticks, std::memory_order_relaxed);
+
+    if (numSamples > 0)
+    {
+        const auto load = (double) ticks / ticksPerSecond * sampleRate.load (std::memory_order_relaxed) / numSamples;
+
+        if (load > 1.0)
+            increment (numOverruns);
+
+        if (load > maximumLoad.load (std::memory_order_relaxed))
+            maximumLoad.store (load, std::memory_order_relaxed);
+    }
+}
+
+void Instrumentation::countAllocation() noexcept
+{
+    if (auto* block = currentBlock)
+        increment (block->numAllocations);
+}
+
+void Instrumentation::countDeallocation() noexcept
+{
+    if (auto* block = currentBlock)
+        increment (block->numDeallocations);
+}
+
+void Instrumentation::countLock() noexcept
+{
+    if (auto* block = currentBlock)
+        increment (block->numLocks);
+}
+
+//==============================================================================
+#if VOCALCOMPRESSOR_INSTRUMENTATION
+
+#include <cstdlib>
+#include <new>
+
+// Replacing the global allocation functions catches every allocation made
+// by code linked into this binary: the plugin, its JUCE modules and inlined
+// standard library code.
+namespace
+{
+    void* allocate (std::size_t size)
+    {
+        Instrumentation::countAllocation();
+
+        if (auto* memory = std::malloc (size == 0 ? 1 : size))
+            return memory;
+
+        throw std::bad_alloc();
+    }
+
+    void* allocateAligned (std::size_t size, std::align_val_t alignment)
+    {
+        Instrumentation::countAllocation();
+
+       #if JUCE_WINDOWS
+        if (auto* memory = _aligned_malloc (size == 0 ? 1 : size, (std::size_t) alignment))
+            return memory;
+       #else
+        void* memory = nullptr;
+
+        if (posix_memalign (&memory, juce::jmax (sizeof (void*), (std::size_t) alignment), size == 0 ? 1 : size) == 0)
+            return memory;
+       #endif
+
+        throw std::bad_alloc();
+    }
+
+    void release (void* memory) noexcept
+    {
+        if (memory != nullptr)
+        {
+            Instrumentation::countDeallocation();
+            std::free (memory);
+        }
+    }
+
+    void releaseAligned (void* memory) noexcept
+    {
+        if (memory != nullptr)
+        {
+            Instrumentation::countDeallocation();
+
+           #if JUCE_WINDOWS
+            _aligned_free (memory);
+           #else
+            std::free (memory);
+           #endif
+        }
+    }
+}
+
+void* operator new (std::size_t size)                                   { return allocate (size); }
+void* operator new[] (std::size_t size)                                 { return allocate (size); }
+void* operator new (std::size_t size, std::align_val_t alignment)       { return allocateAligned (size, alignment); }
+void* operator new[] (std::size_t size, std::align_val_t alignment)     { return allocateAligned (size, alignment); }
+
+void* operator new (std::size_t size, const std::nothrow_t&) noexcept
+{
+    try { return allocate (size); } catch (...) { return nullptr; }
+}
+
+void* operator new[] (std::size_t size, const std::nothrow_t&) noexcept
+{
+    try { return allocate (size); } catch (...) { return nullptr; }
+}
+
+void* operator new (std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    try { return allocateAligned (size, alignment); } catch (...) { return nullptr; }
+}
+
+void* operator new[] (std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    try { return allocateAligned (size, alignment); } catch (...) { return nullptr; }
+}
+
+void operator delete (void* memory) noexcept                                            { release (memory); }
+void operator delete[] (void* memory) noexcept                                          { release (memory); }
+void operator delete (void* memory, std::size_t) noexcept                               { release (memory); }
+void operator delete[] (void* memory, std::size_t) noexcept                             { release (memory); }
+void operator delete (void* memory, std::align_val_t) noexcept                          { releaseAligned (memory); }
+void operator delete[] (void* memory, std::align_val_t) noexcept                        { releaseAligned (memory); }
+void operator delete (void* memory, std::size_t, std::align_val_t) noexcept             { releaseAligned (memory); }
+void operator delete[] (void* memory, std::size_t, std::align_val_t) noexcept           { releaseAligned (memory); }
+void operator delete (void* memory, const std::nothrow_t&) noexcept                     { release (memory); }
+void operator delete[] (void* memory, const std::nothrow_t&) noexcept                   { release (memory); }
+void operator delete (void* memory, std::align_val_t, const std::nothrow_t&) noexcept  { releaseAligned (memory); }
+void operator delete[] (void* memory, std::align_val_t, const std::nothrow_t&) noexcept { releaseAligned (memory); }
+
+//==============================================================================
+#if JUCE_LINUX || JUCE_MAC
+
+#include <dlfcn.h>
+#include <pthread.h>
+
+// Calls from this binary bind to this definition instead of the system's,
+// which covers juce::CriticalSection, std::mutex and anything else built on
+// pthread mutexes. The real function is kept at file scope rather than in
+// a static local, whose initialisation guard could itself take a mutex.
+namespace
+{
+    using LockFunction = int (*) (pthread_mutex_t*);
+    std::atomic<LockFunction> systemLock { nullptr };
+}
+
+extern "C" int pthread_mutex_lock (pthread_mutex_t* mutex)
+{
+    auto lock = systemLock.load (std::memory_order_relaxed);
+
+    if (lock == nullptr)
+    {
+        lock = (LockFunction) dlsym (RTLD_NEXT, "pthread_mutex_lock");
+        systemLock.store (lock, std::memory_order_relaxed);
+    }
+
+    Instrumentation::countLock();
+    return lock (mutex);
+}
+
+#endif
+#endif
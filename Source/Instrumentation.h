@@ -0,0 +1,118 @@
+/*
+  ==============================================================================
+
+    Instrumentation.h
+
+    Real-time safety instrumentation for the audio thread. It is compiled
+    into the plugin when VOCALCOMPRESSOR_INSTRUMENTATION is defined to 1,
+    e.g. in the preprocessor definitions of a separate build configuration,
+    and costs nothing otherwise.
+
+    Every processBlock() call is timed and counted in a histogram with four
+    bins per octave. A block that takes longer than the audio it contains
+    counts as an overrun. While a block runs, the plugin's own heap
+    allocations and releases through the global operator new and delete, and
+    its mutex locks through pthread_mutex_lock (Linux and macOS), are
+    counted against it. Nothing is reported from the audio thread itself:
+    it only updates relaxed atomics, and the editor's debug panel reads
+    them as a Snapshot.
+
+    Snapshots convert to and from JSON. That is the dump the debug panel
+    writes and the benchmark's --report option reads, so this file is
+    always compiled and only the hooks depend on the flag.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <array>
+#include <atomic>
+
+#ifndef VOCALCOMPRESSOR_INSTRUMENTATION
+ #define VOCALCOMPRESSOR_INSTRUMENTATION 0
+#endif
+
+//==============================================================================
+class Instrumentation
+{
+public:
+    static constexpr int numBins = 64;
+    static constexpr int binsPerOctave = 4;
+
+    /** The upper edge of bin 0. */
+    static constexpr double lowestMicroseconds = 2.0;
+
+    /** The upper edge of a bin in microseconds. The last bin has no upper edge. */
+    static double getBinEdge (int bin) noexcept;
+
+    //==============================================================================
+    struct Snapshot
+    {
+        double sampleRate = 0.0;
+        juce::int64 numBlocks = 0, numOverruns = 0;
+        juce::int64 numAllocations = 0, numDeallocations = 0, numLocks = 0;
+        double totalMicroseconds = 0.0, maximumMicroseconds = 0.0;
+        double maximumLoad = 0.0;       // of the slowest block, relative to its duration
+        std::array<juce::int64, numBins> histogram {};
+
+        /** The upper bin edge below which the given fraction of the blocks fell. */
+        double getPercentile (double fraction) const noexcept;
+
+        juce::var toVar() const;
+
+        /** Returns false if the var is not a dump with the same bins. */
+        static bool fromVar (const juce::var&, Snapshot& result);
+    };
+
+    //==============================================================================
+    void prepare (double newSampleRate) noexcept;
+
+    /** Clears the counters at the start of the next block. Call it from any thread. */
+    void reset() noexcept       { resetRequested.store (true, std::memory_order_relaxed); }
+
+    Snapshot getSnapshot() const noexcept;
+
+    //==============================================================================
+    /** Times one block and attributes allocations and locks on this thread to it. */
+    class ScopedBlock
+    {
+    public:
+        ScopedBlock (Instrumentation&, int numSamples) noexcept;
+        ~ScopedBlock() noexcept;
+
+    private:
+        Instrumentation& owner;
+        Instrumentation* const previous;
+        const int numSamples;
+        const juce::int64 startTicks;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedBlock)
+    };
+
+    /** Called by the hooks, counted against the block running on this thread, if any. */
+    static void countAllocation() noexcept;
+    static void countDeallocation() noexcept;
+    static void countLock() noexcept;
+
+private:
+    void clear() noexcept;
+    void addBlock (juce::int64 ticks, int numSamples) noexcept;
+
+    static void increment (std::atomic<juce::int64>& counter) noexcept
+    {
+        counter.store (counter.load (std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    std::atomic<double> sampleRate { 44100.0 };
+    std::atomic<bool> resetRequested { false };
+
+    // Only the audio thread writes these
+    std::atomic<juce::int64> numBlocks { 0 }, numOverruns { 0 };
+    std::atomic<juce::int64> numAllocations { 0 }, numDeallocations { 0 }, numLocks { 0 };
+    std::atomic<juce::int64> totalTicks { 0 }, maximumTicks { 0 };
+    std::atomic<double> maximumLoad { 0.0 };
+    std::array<std::atomic<juce::int64>, numBins> histogram {};
+};
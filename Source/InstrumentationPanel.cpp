@@ -0,0 +1,145 @@
+/*
+  ==============================================================================
+
+    InstrumentationPanel.cpp
+
+  ==============================================================================
+*/
+
+#include "InstrumentationPanel.h"
+
+namespace
+{
+    constexpr int textWidth = 200;
+    constexpr int buttonHeight = 20;
+}
+
+//==============================================================================
+InstrumentationPanel::InstrumentationPanel (Instrumentation& source, juce::Colour text, juce::Colour bar,
+                                            juce::Colour alert, juce::Colour grid, juce::Colour background)
+    : instrumentation (source),
+      textColour (text), barColour (bar), alertColour (alert), gridColour (grid), backgroundColour (background)
+{
+    setOpaque (true);
+
+    for (auto* button : { &resetButton, &dumpButton })
+    {
+        addAndMakeVisible (button);
+        button->setColour (juce::TextButton::ColourIds::buttonColourId, backgroundColour);
+        button->setColour (juce::TextButton::ColourIds::textColourOffId, textColour);
+        button->setColour (juce::ComboBox::ColourIds::outlineColourId, gridColour);
+    }
+
+    resetButton.onClick = [this]
+    {
+        instrumentation.reset();
+        lastDump.clear();
+    };
+
+    dumpButton.onClick = [this] { dump(); };
+}
+
+void InstrumentationPanel::update()
+{
+    snapshot = instrumentation.getSnapshot();
+    repaint();
+}
+
+void InstrumentationPanel::dump()
+{
+    auto file = juce::File::getSpecialLocation (juce::File::userDocumentsDirectory)
+                    .getNonexistentChildFile ("VocalCompressorInstrumentation", ".json");
+
+    lastDump = file.replaceWithText (juce::JSON::toString (instrumentation.getSnapshot().toVar()))
+                 ? file.getFullPathName()
+                 : "Could not write " + file.getFullPathName();
+    repaint();
+}
+
+//==============================================================================
+void InstrumentationPanel::paint (juce::Graphics& g)
+{
+    g.fillAll (backgroundColour);
+
+    // Statistics on the left
+    const auto meanMicroseconds = snapshot.numBlocks > 0 ? snapshot.totalMicroseconds / (double) snapshot.numBlocks : 0.0;
+
+    const std::pair<juce::String, bool> lines[] =
+    {
+        { "Blocks " + juce::String (snapshot.numBlocks), false },
+        { "Overruns " + juce::String (snapshot.numOverruns), snapshot.numOverruns > 0 },
+        { juce::String::formatted ("Mean %.1f us, p50 %.1f us", meanMicroseconds, snapshot.getPercentile (0.5)), false },
+        { juce::String::formatted ("p99 %.1f us, max %.1f us", snapshot.getPercentile (0.99), snapshot.maximumMicroseconds), false },
+        { juce::String::formatted ("Max load %.0f%%", 100.0 * snapshot.maximumLoad), snapshot.maximumLoad > 1.0 },
+        { "Allocations " + juce::String (snapshot.numAllocations)
+            + ", frees " + juce::String (snapshot.numDeallocations), snapshot.numAllocations + snapshot.numDeallocations > 0 },
+        { "Locks " + juce::String (snapshot.numLocks), snapshot.numLocks > 0 }
+    };
+
+    g.setFont (12);
+    int y = 0;
+
+    for (const auto& [line, alert] : lines)
+    {
+        g.setColour (alert ? alertColour : textColour);
+        g.drawFittedText (line, 0, y, textWidth, 16, juce::Justification::left, 1);
+        y += 16;
+    }
+
+    if (lastDump.isNotEmpty())
+    {
+        g.setColour (gridColour);
+        g.drawFittedText (lastDump, 0, getHeight() - buttonHeight - 20, getWidth(), 16, juce::Justification::left, 1);
+    }
+
+    // Histogram on the right, one bar per bin on a log scale of block counts
+    const auto area = getLocalBounds().withTrimmedLeft (textWidth).withTrimmedBottom (buttonHeight + 24).toFloat();
+
+    if (area.isEmpty())
+        return;
+
+    g.setColour (gridColour);
+    g.drawRect (area);
+
+    juce::int64 largest = 0;
+
+    for (auto count : snapshot.histogram)
+        largest = juce::jmax (largest, count);
+
+    const auto barWidth = area.getWidth() / Instrumentation::numBins;
+    const auto scale = largest > 0 ? area.getHeight() / std::log1p ((float) largest) : 0.0f;
+
+    for (int bin = 0; bin < Instrumentation::numBins; ++bin)
+    {
+        const auto count = snapshot.histogram[(size_t) bin];
+
+        if (count == 0)
+            continue;
+
+        const auto height = std::log1p ((float) count) * scale;
+
+        g.setColour (barColour);
+        g.fillRect (area.getX() + bin * barWidth, area.getBottom() - height, juce::jmax (1.0f, barWidth - 1.0f), height);
+    }
+
+    // Labels at every other octave
+    g.setColour (gridColour);
+    g.setFont (10);
+
+    for (int bin = 0; bin < Instrumentation::numBins - 1; bin += 2 * Instrumentation::binsPerOctave)
+    {
+        const auto x = area.getX() + (bin + 1) * barWidth;
+        const auto edge = Instrumentation::getBinEdge (bin);
+
+        g.drawFittedText (edge < 1000.0 ? juce::String (juce::roundToInt (edge)) + " us"
+                                        : juce::String (edge / 1000.0, 1) + " ms",
+                          juce::roundToInt (x) - 20, juce::roundToInt (area.getBottom()) + 2, 40, 14,
+                          juce::Justification::centred, 1);
+    }
+}
+
+void InstrumentationPanel::resized()
+{
+    resetButton.setBounds (0, getHeight() - buttonHeight, 80, buttonHeight);
+    dumpButton.setBounds (90, getHeight() - buttonHeight, 80, buttonHeight);
+}
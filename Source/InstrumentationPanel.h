@@ -0,0 +1,46 @@
+/*
+  ==============================================================================
+
+    InstrumentationPanel.h
+
+    The debug panel of instrumentation builds. It shows the histogram of
+    processBlock() times on a logarithmic count scale, the overrun count
+    and the allocations and locks seen on the audio thread, in the alert
+    colour when they are not zero. "Dump" writes the current snapshot as JSON to the documents
+    folder, for the benchmark's --report option.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "Instrumentation.h"
+
+//==============================================================================
+class InstrumentationPanel  : public juce::Component
+{
+public:
+    InstrumentationPanel (Instrumentation&, juce::Colour textColour, juce::Colour barColour,
+                          juce::Colour alertColour, juce::Colour gridColour, juce::Colour backgroundColour);
+
+    /** Takes a new snapshot. Called from the editor's timer. */
+    void update();
+
+    //==============================================================================
+    void paint (juce::Graphics&) override;
+    void resized() override;
+
+private:
+    void dump();
+
+    Instrumentation& instrumentation;
+    Instrumentation::Snapshot snapshot;
+
+    const juce::Colour textColour, barColour, alertColour, gridColour, backgroundColour;
+
+    juce::TextButton resetButton { "Reset" }, dumpButton { "Dump" };
+    juce::String lastDump;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (InstrumentationPanel)
+};
@@ -0,0 +1,129 @@
+/*
+  ==============================================================================
+
+    MeterDisplay.cpp
+
+  ==============================================================================
+*/
+
+#include "MeterDisplay.h"
+
+namespace
+{
+    constexpr float levelFloorDb = -60.0f;
+    constexpr float reductionRangeDb = 24.0f;
+
+    // How fast the bars fall back once the signal drops, in dB per refresh
+    constexpr float releaseDb = 24.0f / MeterDisplay::refreshRate;
+
+    float toDecibels (float gain)
+    {
+        return juce::Decibels::gainToDecibels (gain, -100.0f);
+    }
+}
+
+//==============================================================================
+MeterDisplay::MeterDisplay (juce::Colour level, juce::Colour reduction,
+                            juce::Colour track, juce::Colour background)
+    : levelColour (level), reductionColour (reduction),
+      trackColour (track), backgroundColour (background)
+{
+    setOpaque (true);
+}
+
+//==============================================================================
+void MeterDisplay::update (const MeterFrame* frames, int numFrames)
+{
+    float inputPeak = 0.0f, outputPeak = 0.0f;
+    double inputSquares = 0.0, outputSquares = 0.0;
+    float reduction = 0.0f;
+    int numSamples = 0;
+
+    for (int i = 0; i < numFrames; ++i)
+    {
+        const auto& frame = frames[i];
+
+        inputPeak  = juce::jmax (inputPeak,  frame.inputPeak);
+        outputPeak = juce::jmax (outputPeak, frame.outputPeak);
+        inputSquares  += frame.inputSquares;
+        outputSquares += frame.outputSquares;
+        reduction = juce::jmin (reduction, frame.gainReductionDb);
+        numSamples += frame.numSamples;
+    }
+
+    const float inputRms  = numSamples > 0 ? (float) std::sqrt (inputSquares  / numSamples) : 0.0f;
+    const float outputRms = numSamples > 0 ? (float) std::sqrt (outputSquares / numSamples) : 0.0f;
+
+    // Rise instantly, fall at a fixed rate
+    const auto follow = [] (float& shown, float target)
+    {
+        const auto next = juce::jmax (target, shown - releaseDb);
+        const bool changed = std::abs (next - shown) > 0.05f;
+        shown = next;
+        return changed;
+    };
+
+    bool changed = false;
+    changed |= follow (inputPeakDb,  toDecibels (inputPeak));
+    changed |= follow (inputRmsDb,   toDecibels (inputRms));
+    changed |= follow (outputPeakDb, toDecibels (outputPeak));
+    changed |= follow (outputRmsDb,  toDecibels (outputRms));
+
+    const auto nextReduction = juce::jmin (reduction, reductionDb + releaseDb);
+    changed |= std::abs (nextReduction - reductionDb) > 0.05f;
+    reductionDb = nextReduction;
+
+    if (changed)
+        repaint();
+}
+
+//==============================================================================
+void MeterDisplay::paint (juce::Graphics& g)
+{
+    g.fillAll (backgroundColour);
+
+    auto area = getLocalBounds().toFloat();
+    const auto barWidth = area.getWidth() / 3.0f;
+
+    drawBar (g, area.removeFromLeft (barWidth).reduced (3.0f, 0.0f), "In", inputRmsDb, inputPeakDb);
+    drawBar (g, area.removeFromLeft (barWidth).reduced (3.0f, 0.0f), "Out", outputRmsDb, outputPeakDb);
+    drawReduction (g, area.reduced (3.0f, 0.0f), reductionDb);
+}
+
+void MeterDisplay::drawBar (juce::Graphics& g, juce::Rectangle<float> area, const juce::String& name,
+                            float rmsDb, float peakDb) const
+{
+    g.setColour (trackColour);
+    g.setFont (12.0f);
+    g.drawText (name, area.removeFromBottom (20.0f), juce::Justification::centred, false);
+
+    g.fillRect (area);
+
+    const auto proportion = [] (float decibels)
+    {
+        return juce::jlimit (0.0f, 1.0f, (decibels - levelFloorDb) / -levelFloorDb);
+    };
+
+    const auto height = area.getHeight();
+
+    g.setColour (levelColour);
+    g.fillRect (area.withTop (area.getBottom() - height * proportion (rmsDb)));
+
+    const auto peakY = area.getBottom() - height * proportion (peakDb);
+    g.fillRect (area.getX(), juce::jmin (peakY, area.getBottom() - 2.0f), area.getWidth(), 2.0f);
+}
+
+void MeterDisplay::drawReduction (juce::Graphics& g, juce::Rectangle<float> area, float decibels) const
+{
+    g.setColour (trackColour);
+    g.setFont (12.0f);
+    g.drawText ("GR", area.removeFromBottom (20.0f), juce::Justification::centred, false);
+
+    g.fillRect (area);
+
+    // Hangs down from the top
+    const auto proportion = juce::jlimit (0.0f, 1.0f, -decibels / reductionRangeDb);
+
+    g.setColour (reductionColour);
+    g.fillRect (area.withHeight (area.getHeight() * proportion));
+}
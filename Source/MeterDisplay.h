@@ -0,0 +1,49 @@
+/*
+  ==============================================================================
+
+    MeterDisplay.h
+
+    Input, output and gain reduction bars. The editor pops the MeterFeed on
+    a timer and hands the frames to update().
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "MeterFeed.h"
+
+//==============================================================================
+class MeterDisplay  : public juce::Component
+{
+public:
+    /** How often update() is expected to be called, in Hz. */
+    static constexpr int refreshRate = 30;
+
+    MeterDisplay (juce::Colour levelColour, juce::Colour reductionColour,
+                  juce::Colour trackColour, juce::Colour backgroundColour);
+
+    /** Takes the frames that arrived since the last call. Repaints only if
+        the bars moved.
+    */
+    void update (const MeterFrame* frames, int numFrames);
+
+    //==============================================================================
+    void paint (juce::Graphics&) override;
+
+private:
+    void drawBar (juce::Graphics&, juce::Rectangle<float> area, const juce::String& name,
+                  float rmsDb, float peakDb) const;
+
+    void drawReduction (juce::Graphics&, juce::Rectangle<float> area, float reductionDb) const;
+
+    const juce::Colour levelColour, reductionColour, trackColour, backgroundColour;
+
+    // Displayed values in dB, after peak hold and release
+    float inputPeakDb = -100.0f, inputRmsDb = -100.0f;
+    float outputPeakDb = -100.0f, outputRmsDb = -100.0f;
+    float reductionDb = 0.0f;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MeterDisplay)
+};
@@ -0,0 +1,87 @@
+/*
+  ==============================================================================
+
+    MeterFeed.h
+
+    Carries the levels of each processed block from the audio thread to the
+    editor. The audio thread is the only writer and the editor's timer the
+    only reader, so a juce::AbstractFifo over a fixed array is enough: push()
+    never blocks or allocates, and drops the frame if the editor has fallen
+    behind.
+
+    The editor switches the feed on while it is open. While it is off the
+    processor neither gathers levels nor pushes anything.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <array>
+#include <atomic>
+
+//==============================================================================
+/** The levels of one block, summed over all channels. */
+struct MeterFrame
+{
+    float inputPeak = 0.0f, outputPeak = 0.0f;
+    float inputSquares = 0.0f, outputSquares = 0.0f;
+    float gainReductionDb = 0.0f;
+    int numSamples = 0;
+};
+
+//==============================================================================
+class MeterFeed
+{
+public:
+    /** Called by the editor. */
+    void setActive (bool shouldBeActive) noexcept   { active.store (shouldBeActive, std::memory_order_relaxed); }
+
+    bool isActive() const noexcept                  { return active.load (std::memory_order_relaxed); }
+
+    /** Called on the audio thread with the levels of the block just processed. */
+    template <typename Levels>
+    void push (const Levels& levels) noexcept
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite (1, start1, size1, start2, size2);
+
+        if (size1 == 0)
+            return;
+
+        auto& frame = frames[(size_t) start1];
+        frame.inputPeak       = (float) levels.inputPeak;
+        frame.outputPeak      = (float) levels.outputPeak;
+        frame.inputSquares    = (float) levels.inputSquares;
+        frame.outputSquares   = (float) levels.outputSquares;
+        frame.gainReductionDb = (float) levels.gainReductionDb;
+        frame.numSamples      = levels.numSamples;
+
+        fifo.finishedWrite (1);
+    }
+
+    /** Called on the message thread. Returns the number of frames copied. */
+    int pop (MeterFrame* dest, int maxFrames) noexcept
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead (maxFrames, start1, size1, start2, size2);
+
+        for (int i = 0; i < size1; ++i)
+            dest[i] = frames[(size_t) (start1 + i)];
+
+        for (int i = 0; i < size2; ++i)
+            dest[size1 + i] = frames[(size_t) (start2 + i)];
+
+        fifo.finishedRead (size1 + size2);
+        return size1 + size2;
+    }
+
+    static constexpr int capacity = 1024;
+
+private:
+    juce::AbstractFifo fifo { capacity };
+    std::array<MeterFrame, capacity> frames;
+    std::atomic<bool> active { false };
+};
@@ -0,0 +1,185 @@
+/*
+  ==============================================================================
+
+    ParameterSnapshot.cpp
+
+  ==============================================================================
+*/
+
+#include "ParameterSnapshot.h"
+
+namespace
+{
+    float getPlainValue (const juce::AudioProcessorParameter& parameter)
+    {
+        // Read directly where possible, the normalised round trip can move the last bit
+        if (auto* choice = dynamic_cast<const juce::AudioParameterChoice*> (&parameter))
+            return (float) choice->getIndex();
+
+        if (auto* floatParameter = dynamic_cast<const juce::AudioParameterFloat*> (&parameter))
+            return floatParameter->get();
+
+        if (auto* ranged = dynamic_cast<const juce::RangedAudioParameter*> (&parameter))
+            return ranged->convertFrom0to1 (parameter.getValue());
+
+        return parameter.getValue();
+    }
+
+    float getPlainDefault (const juce::AudioProcessorParameter& parameter)
+    {
+        if (auto* ranged = dynamic_cast<const juce::RangedAudioParameter*> (&parameter))
+            return ranged->convertFrom0to1 (parameter.getDefaultValue());
+
+        return parameter.getDefaultValue();
+    }
+
+    /** Clamped and snapped, so the audio thread reads the same value from a
+        snapshot as from the parameter it is applied to.
+    */
+    float getLegalValue (const juce::AudioProcessorParameter& parameter, float plainValue)
+    {
+        if (auto* ranged = dynamic_cast<const juce::RangedAudioParameter*> (&parameter))
+            return ranged->getNormalisableRange().snapToLegalValue (plainValue);
+
+        return juce::jlimit (0.0f, 1.0f, plainValue);
+    }
+
+    float getNormalisedValue (const juce::AudioProcessorParameter& parameter, float plainValue)
+    {
+        if (auto* ranged = dynamic_cast<const juce::RangedAudioParameter*> (&parameter))
+            return ranged->convertTo0to1 (plainValue);
+
+        return plainValue;
+    }
+
+    juce::String getID (const juce::AudioProcessorParameter& parameter)
+    {
+        if (auto* withID = dynamic_cast<const juce::AudioProcessorParameterWithID*> (&parameter))
+            return withID->getParameterID();
+
+        return juce::String (parameter.getParameterIndex());
+    }
+
+    /** 32-bit FNV-1a of the ID's UTF-8 bytes, stable across builds and platforms. */
+    juce::uint32 getKey (const juce::AudioProcessorParameter& parameter)
+    {
+        juce::uint32 hash = 2166136261u;
+
+        for (auto* c = getID (parameter).toRawUTF8(); *c != 0; ++c)
+            hash = (hash ^ (juce::uint8) *c) * 16777619u;
+
+        return hash;
+    }
+
+    int getNumValues (const ParameterSnapshot::ParameterList& parameters)
+    {
+        jassert (parameters.size() <= ParameterSnapshot::maximumParameters);
+        return juce::jmin (parameters.size(), ParameterSnapshot::maximumParameters);
+    }
+}
+
+//==============================================================================
+ParameterSnapshot ParameterSnapshot::fromDefaults (const ParameterList& parameters)
+{
+    ParameterSnapshot snapshot;
+    snapshot.numValues = getNumValues (parameters);
+
+    for (int i = 0; i < snapshot.numValues; ++i)
+        snapshot.values[(size_t) i] = getPlainDefault (*parameters[i]);
+
+    return snapshot;
+}
+
+ParameterSnapshot ParameterSnapshot::fromParameters (const ParameterList& parameters)
+{
+    ParameterSnapshot snapshot;
+    snapshot.numValues = getNumValues (parameters);
+
+    for (int i = 0; i < snapshot.numValues; ++i)
+        snapshot.values[(size_t) i] = getPlainValue (*parameters[i]);
+
+    return snapshot;
+}
+
+void ParameterSnapshot::setFrom (const juce::NamedValueSet& valuesById, const ParameterList& parameters)
+{
+    for (int i = 0; i < numValues; ++i)
+        if (auto* value = valuesById.getVarPointer (getID (*parameters[i])))
+            values[(size_t) i] = getLegalValue (*parameters[i], (float) (double) *value);
+}
+
+void ParameterSnapshot::applyTo (const ParameterList& parameters) const
+{
+    for (int i = 0; i < numValues; ++i)
+    {
+        auto& parameter = *parameters[i];
+
+        if (values[(size_t) i] != getPlainValue (parameter))
+            parameter.setValueNotifyingHost (getNormalisedValue (parameter, values[(size_t) i]));
+    }
+}
+
+//==============================================================================
+void ParameterSnapshot::writeBinary (juce::MemoryBlock& destData, const ParameterList& parameters) const
+{
+    juce::MemoryOutputStream stream (destData, false);
+    stream.writeInt ((int) binaryMagic);
+    stream.writeShort ((short) binaryVersion);
+    stream.writeShort ((short) numValues);
+
+    for (int i = 0; i < numValues; ++i)
+    {
+        stream.writeInt ((int) getKey (*parameters[i]));
+        stream.writeFloat (values[(size_t) i]);
+    }
+}
+
+bool ParameterSnapshot::readBinary (const void* data, int sizeInBytes, const ParameterList& parameters)
+{
+    constexpr int headerSize = 8, entrySize = 8;
+
+    if (data == nullptr || sizeInBytes < headerSize)
+        return false;
+
+    juce::MemoryInputStream stream (data, (size_t) sizeInBytes, false);
+
+    if ((juce::uint32) stream.readInt() != binaryMagic)
+        return false;
+
+    // A state saved by a newer version is left alone rather than misread
+    const int version = (juce::uint16) stream.readShort();
+    const int numEntries = (juce::uint16) stream.readShort();
+
+    if (version < 1 || version > binaryVersion || sizeInBytes < headerSize + numEntries * entrySize)
+        return false;
+
+    std::array<juce::uint32, maximumParameters> keys;
+
+    for (int i = 0; i < numValues; ++i)
+        keys[(size_t) i] = getKey (*parameters[i]);
+
+    for (int entry = 0; entry < numEntries; ++entry)
+    {
+        const auto key = (juce::uint32) stream.readInt();
+        const auto value = stream.readFloat();
+
+        if (! std::isfinite (value))
+            continue;
+
+        for (int i = 0; i < numValues; ++i)
+            if (keys[(size_t) i] == key)
+                values[(size_t) i] = getLegalValue (*parameters[i], value);
+    }
+
+    return true;
+}
+
+juce::NamedValueSet ParameterSnapshot::getAttributes (const juce::XmlElement& xml)
+{
+    juce::NamedValueSet attributes;
+
+    for (int i = 0; i < xml.getNumAttributes(); ++i)
+        attributes.set (xml.getAttributeName (i), xml.getAttributeValue (i).getDoubleValue());
+
+    return attributes;
+}
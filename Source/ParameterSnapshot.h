@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+
+    ParameterSnapshot.h
+
+    The plain values of all of the processor's parameters at one moment: a
+    choice parameter's index, a float parameter's value in its own units.
+    It is the unit the saved state, the preset bank and program switches
+    deal in. Values are kept in parameter order in a fixed array, so the
+    audio thread can read a snapshot without allocating.
+
+    The binary state is a little-endian header followed by one entry per
+    parameter:
+
+        uint32  magic ('VCSB')
+        uint16  version
+        uint16  number of entries
+        entries of { uint32 FNV-1a hash of the parameter ID, float32 value }
+
+    Entries are matched by ID rather than position, so parameters can be
+    added or reordered without breaking older sessions. Unknown IDs are
+    skipped and missing ones keep their current value, as with the XML
+    state that came before it.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <array>
+
+//==============================================================================
+struct ParameterSnapshot
+{
+    static constexpr int maximumParameters = 32;
+    static constexpr juce::uint32 binaryMagic = 0x42534356;    // "VCSB"
+    static constexpr int binaryVersion = 1;
+
+    using ParameterList = juce::Array<juce::AudioProcessorParameter*>;
+
+    std::array<float, maximumParameters> values {};
+    int numValues = 0;
+
+    /** The value of one of the processor's parameters. */
+    float operator[] (const juce::AudioProcessorParameter& parameter) const noexcept
+    {
+        return values[(size_t) parameter.getParameterIndex()];
+    }
+
+    //==============================================================================
+    /** Every parameter at its default value. */
+    static ParameterSnapshot fromDefaults (const ParameterList&);
+
+    /** The parameters' current values. */
+    static ParameterSnapshot fromParameters (const ParameterList&);
+
+    /** Overwrites the values that the set has an entry for, keyed by parameter ID. */
+    void setFrom (const juce::NamedValueSet& valuesById, const ParameterList&);
+
+    /** Sets every parameter that differs from the snapshot, notifying the host. */
+    void applyTo (const ParameterList&) const;
+
+    //==============================================================================
+    void writeBinary (juce::MemoryBlock& destData, const ParameterList&) const;
+
+    /** Overwrites the values found in a binary state. Returns false, leaving the
+        snapshot unchanged, if the data is not a binary state this version reads.
+    */
+    bool readBinary (const void* data, int sizeInBytes, const ParameterList&);
+
+    /** The XML attributes as a set keyed by name, the form setFrom() takes. */
+    static juce::NamedValueSet getAttributes (const juce::XmlElement&);
+};
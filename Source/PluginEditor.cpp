@@ -16,12 +16,41 @@ VocalCompressorAudioProcessorEditor::VocalCompressorAudioProcessorEditor (VocalC
         ratioAttachment(*p.ratio, ratioSlider),
         attackAttachment(*p.attack, attackSlider),
         releaseAttachment(*p.release, releaseSlider),
+        lookaheadAttachment(*p.lookahead, lookaheadSlider),
         kneeAttachment(*p.knee, kneeSlider),
-        autoGainAttachment(*p.autoGain, autoGainSlider)
+        autoGainAttachment(*p.autoGain, autoGainSlider),
+        autoGainModeAttachment(*p.autoGainMode, autoGainModeBox),
+        autoGainSmoothingAttachment(*p.autoGainSmoothing, autoGainSmoothingSlider),
+        accuracyAttachment(*p.accuracy, accuracyBox),
+        controlRateAttachment(*p.controlRate, controlRateBox),
+        linkAttachment(*p.link, linkBox),
+        detectorAttachment(*p.detector, detectorBox),
+        oversamplingAttachment(*p.oversampling, oversamplingBox),
+        bandsAttachment(*p.bands, bandsBox),
+        meter(green, red, grey, black),
+        transferCurve(*p.threshold, *p.ratio, *p.knee, red, grey, black),
+        gainReductionHistory(red, grey, black)
 {
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
-    setSize (440, 400);
+   #if VOCALCOMPRESSOR_INSTRUMENTATION
+    setSize (560, 1240);
+   #else
+    setSize (560, 1040);
+   #endif
+    
+    addAndMakeVisible (programBox);
+    
+    for (int i = 0; i < audioProcessor.getNumPrograms(); ++i)
+        programBox.addItem (audioProcessor.getProgramName (i), i + 1);
+    
+    programBox.setSelectedItemIndex (audioProcessor.getCurrentProgram(), juce::dontSendNotification);
+    programBox.onChange = [this] { audioProcessor.setCurrentProgram (programBox.getSelectedItemIndex()); };
+    programBox.setColour(juce::ComboBox::ColourIds::backgroundColourId, black);
+    programBox.setColour(juce::ComboBox::ColourIds::textColourId, grey);
+    programBox.setColour(juce::ComboBox::ColourIds::outlineColourId, grey);
+    programBox.setColour(juce::ComboBox::ColourIds::arrowColourId, white);
+    programBox.setColour(juce::ComboBox::ColourIds::focusedOutlineColourId, white);
     
     addAndMakeVisible (thresholdSlider);
     thresholdSlider.setTextValueSuffix (" dBFS");
@@ -90,6 +119,22 @@ VocalCompressorAudioProcessorEditor::VocalCompressorAudioProcessorEditor (VocalC
     releaseSlider.setColour(juce::Slider::ColourIds::textBoxHighlightColourId, blue);
     releaseSlider.setColour(juce::Slider::ColourIds::textBoxBackgroundColourId, black);
     
+    addAndMakeVisible (lookaheadSlider);
+    lookaheadSlider.setTextValueSuffix (" ms");
+    lookaheadSlider.setRange(lookaheadSlider.getRange(), 0.1f);
+    lookaheadSlider.textFromValueFunction = [](double value)
+    {
+        return juce::String::formatted("%.1f", value);
+    };
+    lookaheadSlider.updateText();
+    lookaheadSlider.setColour(juce::Slider::ColourIds::backgroundColourId, grey);
+    lookaheadSlider.setColour(juce::Slider::ColourIds::thumbColourId, blue);
+    lookaheadSlider.setColour(juce::Slider::ColourIds::trackColourId, grey);
+    lookaheadSlider.setColour(juce::Slider::ColourIds::textBoxTextColourId, grey);
+    lookaheadSlider.setColour(juce::Slider::ColourIds::textBoxOutlineColourId, black);
+    lookaheadSlider.setColour(juce::Slider::ColourIds::textBoxHighlightColourId, blue);
+    lookaheadSlider.setColour(juce::Slider::ColourIds::textBoxBackgroundColourId, black);
+    
     addAndMakeVisible (kneeSlider);
     kneeSlider.setTextValueSuffix (" dB");
     kneeSlider.setRange(kneeSlider.getRange(), 1.f);
@@ -125,10 +170,173 @@ VocalCompressorAudioProcessorEditor::VocalCompressorAudioProcessorEditor (VocalC
     autoGainSlider.setColour(juce::Slider::ColourIds::textBoxOutlineColourId, black);
     autoGainSlider.setColour(juce::Slider::ColourIds::textBoxHighlightColourId, yellow);
     autoGainSlider.setColour(juce::Slider::ColourIds::textBoxBackgroundColourId, black);
+    
+    addAndMakeVisible (autoGainModeBox);
+    autoGainModeBox.setColour(juce::ComboBox::ColourIds::backgroundColourId, black);
+    autoGainModeBox.setColour(juce::ComboBox::ColourIds::textColourId, grey);
+    autoGainModeBox.setColour(juce::ComboBox::ColourIds::outlineColourId, grey);
+    autoGainModeBox.setColour(juce::ComboBox::ColourIds::arrowColourId, yellow);
+    autoGainModeBox.setColour(juce::ComboBox::ColourIds::focusedOutlineColourId, yellow);
+    
+    addAndMakeVisible (autoGainSmoothingSlider);
+    autoGainSmoothingSlider.setTextValueSuffix (" s");
+    autoGainSmoothingSlider.setSkewFactor(0.4f);
+    autoGainSmoothingSlider.textFromValueFunction = [](double value)
+    {
+        return juce::String::formatted("%.1f", value / 1000.0);
+    };
+    autoGainSmoothingSlider.valueFromTextFunction = [](juce::String text)
+    {
+        return text.getDoubleValue() * 1000.0;
+    };
+    autoGainSmoothingSlider.updateText();
+    autoGainSmoothingSlider.setColour(juce::Slider::ColourIds::backgroundColourId, grey);
+    autoGainSmoothingSlider.setColour(juce::Slider::ColourIds::thumbColourId, yellow);
+    autoGainSmoothingSlider.setColour(juce::Slider::ColourIds::trackColourId, grey);
+    autoGainSmoothingSlider.setColour(juce::Slider::ColourIds::textBoxTextColourId, grey);
+    autoGainSmoothingSlider.setColour(juce::Slider::ColourIds::textBoxOutlineColourId, black);
+    autoGainSmoothingSlider.setColour(juce::Slider::ColourIds::textBoxHighlightColourId, yellow);
+    autoGainSmoothingSlider.setColour(juce::Slider::ColourIds::textBoxBackgroundColourId, black);
+    
+    addAndMakeVisible (accuracyBox);
+    accuracyBox.setColour(juce::ComboBox::ColourIds::backgroundColourId, black);
+    accuracyBox.setColour(juce::ComboBox::ColourIds::textColourId, grey);
+    accuracyBox.setColour(juce::ComboBox::ColourIds::outlineColourId, grey);
+    accuracyBox.setColour(juce::ComboBox::ColourIds::arrowColourId, green);
+    accuracyBox.setColour(juce::ComboBox::ColourIds::focusedOutlineColourId, green);
+    
+    addAndMakeVisible (controlRateBox);
+    controlRateBox.setColour(juce::ComboBox::ColourIds::backgroundColourId, black);
+    controlRateBox.setColour(juce::ComboBox::ColourIds::textColourId, grey);
+    controlRateBox.setColour(juce::ComboBox::ColourIds::outlineColourId, grey);
+    controlRateBox.setColour(juce::ComboBox::ColourIds::arrowColourId, green);
+    controlRateBox.setColour(juce::ComboBox::ColourIds::focusedOutlineColourId, green);
+    
+    addAndMakeVisible (linkBox);
+    linkBox.setColour(juce::ComboBox::ColourIds::backgroundColourId, black);
+    linkBox.setColour(juce::ComboBox::ColourIds::textColourId, grey);
+    linkBox.setColour(juce::ComboBox::ColourIds::outlineColourId, grey);
+    linkBox.setColour(juce::ComboBox::ColourIds::arrowColourId, green);
+    linkBox.setColour(juce::ComboBox::ColourIds::focusedOutlineColourId, green);
+    
+    addAndMakeVisible (detectorBox);
+    detectorBox.setColour(juce::ComboBox::ColourIds::backgroundColourId, black);
+    detectorBox.setColour(juce::ComboBox::ColourIds::textColourId, grey);
+    detectorBox.setColour(juce::ComboBox::ColourIds::outlineColourId, grey);
+    detectorBox.setColour(juce::ComboBox::ColourIds::arrowColourId, green);
+    detectorBox.setColour(juce::ComboBox::ColourIds::focusedOutlineColourId, green);
+    
+    addAndMakeVisible (oversamplingBox);
+    oversamplingBox.setColour(juce::ComboBox::ColourIds::backgroundColourId, black);
+    oversamplingBox.setColour(juce::ComboBox::ColourIds::textColourId, grey);
+    oversamplingBox.setColour(juce::ComboBox::ColourIds::outlineColourId, grey);
+    oversamplingBox.setColour(juce::ComboBox::ColourIds::arrowColourId, green);
+    oversamplingBox.setColour(juce::ComboBox::ColourIds::focusedOutlineColourId, green);
+    
+    addAndMakeVisible (bandsBox);
+    bandsBox.setColour(juce::ComboBox::ColourIds::backgroundColourId, black);
+    bandsBox.setColour(juce::ComboBox::ColourIds::textColourId, grey);
+    bandsBox.setColour(juce::ComboBox::ColourIds::outlineColourId, grey);
+    bandsBox.setColour(juce::ComboBox::ColourIds::arrowColourId, white);
+    bandsBox.setColour(juce::ComboBox::ColourIds::focusedOutlineColourId, white);
+    
+    // The band controls are too narrow for a text box, the bars show their values
+    auto setUpBandSlider = [this] (juce::Slider& slider)
+    {
+        addAndMakeVisible (slider);
+        slider.setSliderStyle (juce::Slider::LinearBar);
+        slider.setColour(juce::Slider::ColourIds::trackColourId, grey);
+        slider.setColour(juce::Slider::ColourIds::textBoxTextColourId, white);
+        slider.setColour(juce::Slider::ColourIds::textBoxOutlineColourId, grey);
+        slider.setColour(juce::Slider::ColourIds::textBoxHighlightColourId, white);
+        slider.setColour(juce::Slider::ColourIds::textBoxBackgroundColourId, black);
+    };
+    
+    for (size_t k = 0; k < crossoverSliders.size(); ++k)
+    {
+        auto& slider = crossoverSliders[k];
+        crossoverAttachments[k] = std::make_unique<juce::SliderParameterAttachment> (*p.crossovers[k], slider);
+        setUpBandSlider (slider);
+        slider.setTextValueSuffix (" Hz");
+        slider.textFromValueFunction = [](double value)
+        {
+            return value < 1000.0 ? juce::String::formatted("%.0f", value) : juce::String::formatted("%.1fk", value / 1000.0);
+        };
+        slider.valueFromTextFunction = [](juce::String text)
+        {
+            return text.getDoubleValue() * (text.containsIgnoreCase ("k") ? 1000.0 : 1.0);
+        };
+        slider.updateText();
+    }
+    
+    for (size_t band = 0; band < bandThresholdSliders.size(); ++band)
+    {
+        auto& slider = bandThresholdSliders[band];
+        bandThresholdAttachments[band] = std::make_unique<juce::SliderParameterAttachment> (*p.bandThresholds[band], slider);
+        setUpBandSlider (slider);
+        slider.setTextValueSuffix (" dB");
+        slider.setRange(slider.getRange(), 0.5f);
+        slider.textFromValueFunction = [](double value)
+        {
+            return juce::String::formatted("%+.1f", value);
+        };
+        slider.updateText();
+    }
+    
+    addAndMakeVisible (meter);
+    addAndMakeVisible (transferCurve);
+    addAndMakeVisible (gainReductionHistory);
+    
+   #if VOCALCOMPRESSOR_INSTRUMENTATION
+    instrumentationPanel = std::make_unique<InstrumentationPanel> (audioProcessor.instrumentation, white, blue, red, grey, black);
+    addAndMakeVisible (*instrumentationPanel);
+    resized();
+   #endif
+    
+    // Frames left over from an earlier editor are stale
+    while (audioProcessor.meterFeed.pop (meterFrames.data(), (int) meterFrames.size()) > 0) {}
+    
+    audioProcessor.meterFeed.setActive (true);
+    startTimerHz (MeterDisplay::refreshRate);
 }
 
 VocalCompressorAudioProcessorEditor::~VocalCompressorAudioProcessorEditor()
 {
+    stopTimer();
+    audioProcessor.meterFeed.setActive (false);
+}
+
+void VocalCompressorAudioProcessorEditor::timerCallback()
+{
+    // The array holds the whole feed, so this drains it
+    const int numFrames = audioProcessor.meterFeed.pop (meterFrames.data(), (int) meterFrames.size());
+    
+    meter.update (meterFrames.data(), numFrames);
+    gainReductionHistory.update (meterFrames.data(), numFrames);
+    
+    // The host can switch programs too
+    if (programBox.getSelectedItemIndex() != audioProcessor.getCurrentProgram())
+        programBox.setSelectedItemIndex (audioProcessor.getCurrentProgram(), juce::dontSendNotification);
+    
+    // Only the controls of the bands in use stay enabled
+    const int numBands = audioProcessor.bands->getIndex() == 0 ? 0 : audioProcessor.bands->getIndex() + 1;
+    
+    for (size_t k = 0; k < crossoverSliders.size(); ++k)
+        crossoverSliders[k].setEnabled ((int) k < numBands - 1);
+    
+    for (size_t band = 0; band < bandThresholdSliders.size(); ++band)
+        bandThresholdSliders[band].setEnabled ((int) band < numBands);
+    
+    // The multiband engine has its own peak detector at audio rate, without lookahead or loudness make-up
+    const bool singleBand = numBands == 0;
+    
+    for (auto* control : std::initializer_list<juce::Component*> { &controlRateBox, &linkBox, &detectorBox, &lookaheadSlider,
+                                                                  &autoGainModeBox, &autoGainSmoothingSlider })
+        control->setEnabled (singleBand);
+    
+   #if VOCALCOMPRESSOR_INSTRUMENTATION
+    instrumentationPanel->update();
+   #endif
 }
 
 //==============================================================================
@@ -156,13 +364,57 @@ void VocalCompressorAudioProcessorEditor::paint (juce::Graphics& g)
     g.setFont(15);
     g.drawFittedText("Release", 40, 210, 100, 30, juce::Justification::left, 1);
     
+    g.setColour(blue);
+    g.setFont(15);
+    g.drawFittedText("Lookahead", 40, 250, 100, 30, juce::Justification::left, 1);
+    
     g.setColour(yellow);
     g.setFont(15);
-    g.drawFittedText("Knee", 40, 250, 100, 30, juce::Justification::left, 1);
+    g.drawFittedText("Knee", 40, 290, 100, 30, juce::Justification::left, 1);
     
     g.setColour(yellow);
     g.setFont(15);
-    g.drawFittedText("Auto Gain", 40, 290, 100, 30, juce::Justification::left, 1);
+    g.drawFittedText("Auto Gain", 40, 330, 100, 30, juce::Justification::left, 1);
+    
+    g.setColour(yellow);
+    g.setFont(15);
+    g.drawFittedText("Makeup", 40, 370, 100, 30, juce::Justification::left, 1);
+    
+    g.setColour(yellow);
+    g.setFont(15);
+    g.drawFittedText("Smoothing", 40, 410, 100, 30, juce::Justification::left, 1);
+    
+    g.setColour(green);
+    g.setFont(15);
+    g.drawFittedText("Accuracy", 40, 450, 100, 30, juce::Justification::left, 1);
+    
+    g.setColour(green);
+    g.setFont(15);
+    g.drawFittedText("Control Rate", 40, 490, 100, 30, juce::Justification::left, 1);
+    
+    g.setColour(green);
+    g.setFont(15);
+    g.drawFittedText("Link", 40, 530, 100, 30, juce::Justification::left, 1);
+    
+    g.setColour(green);
+    g.setFont(15);
+    g.drawFittedText("Detector", 40, 570, 100, 30, juce::Justification::left, 1);
+    
+    g.setColour(green);
+    g.setFont(15);
+    g.drawFittedText("Oversampling", 40, 610, 100, 30, juce::Justification::left, 1);
+    
+    g.setColour(white);
+    g.setFont(15);
+    g.drawFittedText("Bands", 40, 650, 100, 30, juce::Justification::left, 1);
+    
+    g.setColour(white);
+    g.setFont(15);
+    g.drawFittedText("Crossovers", 40, 690, 100, 30, juce::Justification::left, 1);
+    
+    g.setColour(white);
+    g.setFont(15);
+    g.drawFittedText("Band Offsets", 40, 730, 100, 30, juce::Justification::left, 1);
     
     g.setColour(grey);
     g.setFont(12);
@@ -173,10 +425,46 @@ void VocalCompressorAudioProcessorEditor::resized()
 {
     // This is generally where you'll want to lay out the positions of any
     // subcomponents in your editor..
-    thresholdSlider .setBounds (140,  95, getWidth() - 140 - 40, 20);
-    ratioSlider     .setBounds (140, 135, getWidth() - 140 - 40, 20);
-    attackSlider    .setBounds (140, 175, getWidth() - 140 - 40, 20);
-    releaseSlider   .setBounds (140, 215, getWidth() - 140 - 40, 20);
-    kneeSlider      .setBounds (140, 255, getWidth() - 140 - 40, 20);
-    autoGainSlider  .setBounds (140, 295, getWidth() - 140 - 40, 20);
+    programBox      .setBounds (getWidth() - 200, 35, 160, 20);
+    thresholdSlider .setBounds (140,  95, getWidth() - 140 - 160, 20);
+    ratioSlider     .setBounds (140, 135, getWidth() - 140 - 160, 20);
+    attackSlider    .setBounds (140, 175, getWidth() - 140 - 160, 20);
+    releaseSlider   .setBounds (140, 215, getWidth() - 140 - 160, 20);
+    lookaheadSlider .setBounds (140, 255, getWidth() - 140 - 160, 20);
+    kneeSlider      .setBounds (140, 295, getWidth() - 140 - 160, 20);
+    autoGainSlider  .setBounds (140, 335, getWidth() - 140 - 160, 20);
+    autoGainModeBox .setBounds (140, 375, getWidth() - 140 - 160, 20);
+    autoGainSmoothingSlider.setBounds (140, 415, getWidth() - 140 - 160, 20);
+    accuracyBox     .setBounds (140, 455, getWidth() - 140 - 160, 20);
+    controlRateBox  .setBounds (140, 495, getWidth() - 140 - 160, 20);
+    linkBox         .setBounds (140, 535, getWidth() - 140 - 160, 20);
+    detectorBox     .setBounds (140, 575, getWidth() - 140 - 160, 20);
+    oversamplingBox .setBounds (140, 615, getWidth() - 140 - 160, 20);
+    bandsBox        .setBounds (140, 655, getWidth() - 140 - 160, 20);
+    
+    // The band rows share the width of one control, with a small gap between them
+    auto layOutRow = [this] (auto& sliders, int y)
+    {
+        const int numSliders = (int) sliders.size();
+        const int width = getWidth() - 140 - 160;
+        
+        for (int i = 0; i < numSliders; ++i)
+        {
+            const int left = 140 + width * i / numSliders;
+            const int right = 140 + width * (i + 1) / numSliders - (i + 1 < numSliders ? 4 : 0);
+            sliders[(size_t) i].setBounds (left, y, right - left, 20);
+        }
+    };
+    
+    layOutRow (crossoverSliders, 695);
+    layOutRow (bandThresholdSliders, 735);
+    
+    meter           .setBounds (getWidth() - 130, 95, 90, 660);
+    transferCurve   .setBounds (40, 780, 160, 160);
+    gainReductionHistory.setBounds (220, 780, getWidth() - 220 - 40, 160);
+    
+   #if VOCALCOMPRESSOR_INSTRUMENTATION
+    if (instrumentationPanel != nullptr)
+        instrumentationPanel->setBounds (40, 970, getWidth() - 80, 180);
+   #endif
 }
@@ -10,11 +10,16 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "MeterDisplay.h"
+#include "TransferCurveDisplay.h"
+#include "GainReductionHistory.h"
+#include "InstrumentationPanel.h"
 
 //==============================================================================
 /**
 */
-class VocalCompressorAudioProcessorEditor  : public juce::AudioProcessorEditor
+class VocalCompressorAudioProcessorEditor  : public juce::AudioProcessorEditor,
+                                             private juce::Timer
 {
 public:
     VocalCompressorAudioProcessorEditor (VocalCompressorAudioProcessor&);
@@ -33,10 +38,14 @@ public:
     void resized() override;
 
 private:
+    void timerCallback() override;
+    
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
     VocalCompressorAudioProcessor& audioProcessor;
     
+    juce::ComboBox programBox;
+    
     juce::Slider thresholdSlider;
     juce::SliderParameterAttachment thresholdAttachment;
     
@@ -49,11 +58,54 @@ private:
     juce::Slider releaseSlider;
     juce::SliderParameterAttachment releaseAttachment;
     
+    juce::Slider lookaheadSlider;
+    juce::SliderParameterAttachment lookaheadAttachment;
+    
     juce::Slider kneeSlider;
     juce::SliderParameterAttachment kneeAttachment;
     
     juce::Slider autoGainSlider;
     juce::SliderParameterAttachment autoGainAttachment;
+    
+    juce::ComboBox autoGainModeBox;
+    juce::ComboBoxParameterAttachment autoGainModeAttachment;
+    
+    juce::Slider autoGainSmoothingSlider;
+    juce::SliderParameterAttachment autoGainSmoothingAttachment;
+    
+    juce::ComboBox accuracyBox;
+    juce::ComboBoxParameterAttachment accuracyAttachment;
+    
+    juce::ComboBox controlRateBox;
+    juce::ComboBoxParameterAttachment controlRateAttachment;
+    
+    juce::ComboBox linkBox;
+    juce::ComboBoxParameterAttachment linkAttachment;
+    
+    juce::ComboBox detectorBox;
+    juce::ComboBoxParameterAttachment detectorAttachment;
+    
+    juce::ComboBox oversamplingBox;
+    juce::ComboBoxParameterAttachment oversamplingAttachment;
+    
+    juce::ComboBox bandsBox;
+    juce::ComboBoxParameterAttachment bandsAttachment;
+    
+    std::array<juce::Slider, VocalDSP::Bands::maximumBands - 1> crossoverSliders;
+    std::array<std::unique_ptr<juce::SliderParameterAttachment>, VocalDSP::Bands::maximumBands - 1> crossoverAttachments;
+    
+    std::array<juce::Slider, VocalDSP::Bands::maximumBands> bandThresholdSliders;
+    std::array<std::unique_ptr<juce::SliderParameterAttachment>, VocalDSP::Bands::maximumBands> bandThresholdAttachments;
+    
+    MeterDisplay meter;
+    TransferCurveDisplay transferCurve;
+    GainReductionHistory gainReductionHistory;
+    
+   #if VOCALCOMPRESSOR_INSTRUMENTATION
+    std::unique_ptr<InstrumentationPanel> instrumentationPanel;
+   #endif
+    
+    std::array<MeterFrame, MeterFeed::capacity> meterFrames;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (VocalCompressorAudioProcessorEditor)
 };
@@ -28,6 +28,43 @@ VocalCompressorAudioProcessor::VocalCompressorAudioProcessor()
     addParameter (release = new juce::AudioParameterFloat ({"release", 1}, "Release", 0.0f, 1000.0f, 250.0f));
     addParameter (knee = new juce::AudioParameterFloat ({"knee", 1}, "Knee", 0.0f, 96.0f, 18.0f));
     addParameter (autoGain = new juce::AudioParameterFloat ({"autoGain", 1}, "Auto Gain", 0.0f, 1.0f, 0.5f));
+    addParameter (accuracy = new juce::AudioParameterChoice ({"accuracy", 1}, "Accuracy", { "Exact", "High", "Fast" }, 1));
+    addParameter (controlRate = new juce::AudioParameterChoice ({"controlRate", 1}, "Control Rate", { "Audio", "1/8", "1/16", "1/32" }, 0));
+    addParameter (link = new juce::AudioParameterChoice ({"link", 1}, "Link", { "Unlinked", "Max", "RMS" }, 0));
+    addParameter (detector = new juce::AudioParameterChoice ({"detector", 1}, "Detector", { "Peak", "RMS", "Log" }, 0));
+    addParameter (lookahead = new juce::AudioParameterFloat ({"lookahead", 1}, "Lookahead", 0.0f, VocalDSP::CompressorKernel<float>::maximumLookaheadMs, 0.0f));
+    addParameter (oversampling = new juce::AudioParameterChoice ({"oversampling", 1}, "Oversampling", { "Off", "2x", "4x", "8x" }, 0));
+    addParameter (bands = new juce::AudioParameterChoice ({"bands", 1}, "Bands", { "Off", "2", "3", "4" }, 0));
+    
+    const VocalDSP::Bands defaultBands;
+    juce::NormalisableRange<float> frequencyRange (20.0f, 20000.0f);
+    frequencyRange.setSkewForCentre (1000.0f);
+    
+    for (size_t k = 0; k < crossovers.size(); ++k)
+    {
+        const auto number = juce::String ((int) k + 1);
+        addParameter (crossovers[k] = new juce::AudioParameterFloat ({"crossover" + number, 1}, "Crossover " + number,
+                                                                     frequencyRange, defaultBands.crossovers[k]));
+    }
+    
+    for (size_t band = 0; band < bandThresholds.size(); ++band)
+    {
+        const auto number = juce::String ((int) band + 1);
+        addParameter (bandThresholds[band] = new juce::AudioParameterFloat ({"bandThreshold" + number, 1}, "Band " + number + " Threshold",
+                                                                            -24.0f, 24.0f, 0.0f));
+    }
+    
+    // Last, so every other parameter keeps its index for hosts that address parameters by index
+    addParameter (autoGainMode = new juce::AudioParameterChoice ({"autoGainMode", 1}, "Auto Gain Mode", { "Curve", "Loudness" }, 0));
+    addParameter (autoGainSmoothing = new juce::AudioParameterFloat ({"autoGainSmoothing", 1}, "Auto Gain Smoothing", 100.0f, 10000.0f, 2000.0f));
+    
+    // Resolved once here, so switching programs needs neither parsing nor allocation
+    for (const auto& preset : presetBank->getPresets())
+    {
+        auto program = ParameterSnapshot::fromDefaults (getParameters());
+        program.setFrom (preset.values, getParameters());
+        programs.push_back (program);
+    }
 }
 
 VocalCompressorAudioProcessor::~VocalCompressorAudioProcessor()
@@ -74,22 +111,49 @@ double VocalCompressorAudioProcessor::getTailLengthSeconds() const
 
 int VocalCompressorAudioProcessor::getNumPrograms()
 {
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
+    // NB: some hosts don't cope very well if you tell them there are 0 programs
+    return juce::jmax (1, (int) programs.size());
 }
 
 int VocalCompressorAudioProcessor::getCurrentProgram()
 {
-    return 0;
+    return currentProgram;
 }
 
 void VocalCompressorAudioProcessor::setCurrentProgram (int index)
 {
+    if (! juce::isPositiveAndBelow (index, (int) programs.size()))
+        return;
+    
+    currentProgram = index;
+    
+    // The snapshots live as long as the processor, so a block can still be
+    // reading this one after it has been withdrawn
+    const auto pending = (juce::uint64) ++programSwitchGeneration << 32 | (juce::uint64) (index + 1) << 1;
+    programSwitch.store (pending, std::memory_order_release);
+    programs[(size_t) index].applyTo (getParameters());
+    programSwitch.store (pending | 1, std::memory_order_release);
+}
+
+const ParameterSnapshot* VocalCompressorAudioProcessor::takeProgramSwitch() noexcept
+{
+    auto state = programSwitch.load (std::memory_order_acquire);
+    
+    if (state == 0)
+        return nullptr;
+    
+    // Applied before this block started, so the live parameters have caught up from the next block on.
+    // Fails harmlessly if another switch has started since.
+    if ((state & 1) != 0)
+        programSwitch.compare_exchange_strong (state, 0, std::memory_order_acq_rel);
+    
+    return &programs[(size_t) ((state & 0xffffffff) >> 1) - 1];
 }
 
 const juce::String VocalCompressorAudioProcessor::getProgramName (int index)
 {
-    return {};
+    const auto& presets = presetBank->getPresets();
+    return juce::isPositiveAndBelow (index, (int) presets.size()) ? presets[(size_t) index].name : juce::String();
 }
 
 void VocalCompressorAudioProcessor::changeProgramName (int index, const juce::String& newName)
@@ -102,16 +166,45 @@ void VocalCompressorAudioProcessor::prepareToPlay (double sampleRate, int sample
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
     
-    juce::dsp::ProcessSpec spec;
-    spec.sampleRate = sampleRate;
-    spec.maximumBlockSize = samplesPerBlock;
-    spec.numChannels = getTotalNumOutputChannels();
+    // Only the engine for the precision the host picked needs buffers
+    if (isUsingDoublePrecision())
+    {
+        doubleEngine.prepare(sampleRate, samplesPerBlock, getTotalNumOutputChannels());
+        floatEngine.prepare(sampleRate, 0, 0);
+    }
+    else
+    {
+        floatEngine.prepare(sampleRate, samplesPerBlock, getTotalNumOutputChannels());
+        doubleEngine.prepare(sampleRate, 0, 0);
+    }
     
-    envelopeFilter.prepare(spec);
-    envelopeFilter.reset();
+    // The lookahead and oversampling buffers are sized for the maximum, so only the reported latency depends on the parameters
+    latencySamples = (bands->getIndex() == 0 ? floatEngine.kernels[0].getLookaheadSamples (*lookahead) : 0)
+                   + VocalDSP::Oversampler<float>::getLatencySamples (oversampling->getIndex());
+    setLatencySamples (latencySamples);
     
-    gain.prepare(spec);
-    gain.reset();
+   #if VOCALCOMPRESSOR_INSTRUMENTATION
+    instrumentation.prepare (sampleRate);
+   #endif
+}
+
+template <typename SampleType>
+void VocalCompressorAudioProcessor::Engine<SampleType>::prepare (double sampleRate, int maximumBlockSize, int numChannels)
+{
+    for (int stages = 0; stages < (int) kernels.size(); ++stages)
+    {
+        kernels[(size_t) stages].prepare (sampleRate * (1 << stages), maximumBlockSize << stages, numChannels);
+        multibands[(size_t) stages].prepare (sampleRate * (1 << stages), maximumBlockSize << stages, numChannels);
+    }
+    
+    oversampler.prepare (maximumBlockSize, numChannels);
+    numStages = 0;
+    multiband = false;
+}
+
+void VocalCompressorAudioProcessor::handleAsyncUpdate()
+{
+    setLatencySamples (latencySamples.load (std::memory_order_relaxed));
 }
 
 void VocalCompressorAudioProcessor::releaseResources()
@@ -127,12 +220,16 @@ bool VocalCompressorAudioProcessor::isBusesLayoutSupported (const BusesLayout& l
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
+    // Mono and stereo, plus the surround layouts used for dialogue stems.
     // Some plugin hosts, such as certain GarageBand versions, will only
     // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    const auto& output = layouts.getMainOutputChannelSet();
+
+    if (output != juce::AudioChannelSet::mono()
+     && output != juce::AudioChannelSet::stereo()
+     && output != juce::AudioChannelSet::create5point1()
+     && output != juce::AudioChannelSet::create7point1()
+     && output != juce::AudioChannelSet::create7point1point4())
         return false;
 
     // This checks if the input layout matches the output layout
@@ -146,37 +243,77 @@ bool VocalCompressorAudioProcessor::isBusesLayoutSupported (const BusesLayout& l
 }
 #endif
 
-float VocalCompressorAudioProcessor::getGainReduction(float envelope)
+template <typename ValueOf>
+VocalDSP::Parameters VocalCompressorAudioProcessor::getKernelParameters (ValueOf&& valueOf) const
 {
-    float lowerKneeBound = *threshold - (*knee / 2.0f);
-    float upperKneeBound = *threshold + (*knee / 2.0f);
+    VocalDSP::Parameters parameters;
+    parameters.threshold = valueOf (*threshold);
+    parameters.ratio = valueOf (*ratio);
+    parameters.attack = valueOf (*attack);
+    parameters.release = valueOf (*release);
+    parameters.lookahead = valueOf (*lookahead);
+    parameters.knee = valueOf (*knee);
+    parameters.autoGain = valueOf (*autoGain);
+    parameters.makeUp = (VocalDSP::MakeUp) (int) valueOf (*autoGainMode);
+    parameters.makeUpSmoothing = valueOf (*autoGainSmoothing);
+    parameters.accuracy = (VocalDSP::Accuracy) (int) valueOf (*accuracy);
     
-    float gainReduction = 1.0f - (1.0f / *ratio);
+    const int controlRateIndex = (int) valueOf (*controlRate);
+    parameters.controlInterval = controlRateIndex == 0 ? 1 : 4 << controlRateIndex;
+    parameters.link = (VocalDSP::Link) (int) valueOf (*link);
+    parameters.detector = (VocalDSP::Detector) (int) valueOf (*detector);
+    return parameters;
+}
 
-    if (envelope < lowerKneeBound)
-    {
-        return 0.0;
-    }
-    else if (envelope < upperKneeBound)
-    {
-        gainReduction *= ((envelope - lowerKneeBound) / *knee) / 2.0f;
-        return gainReduction * (lowerKneeBound - envelope);
-    }
-    else
-    {
-        return gainReduction * (*threshold - envelope);
-    }
+VocalDSP::Parameters VocalCompressorAudioProcessor::getKernelParameters() const
+{
+    // Float parameters read as their value, choices as their index
+    return getKernelParameters ([] (const auto& parameter) { return (float) parameter; });
 }
 
-float VocalCompressorAudioProcessor::processSample (int channel, float sample)
+VocalDSP::Parameters VocalCompressorAudioProcessor::getKernelParameters (const ParameterSnapshot& snapshot) const
 {
-    float envelope = juce::Decibels::gainToDecibels(envelopeFilter.processSample(channel, sample));
-    float gain = getGainReduction(envelope);
-    return sample * juce::Decibels::decibelsToGain(gain);
+    return getKernelParameters ([&snapshot] (const juce::AudioProcessorParameter& parameter) { return snapshot[parameter]; });
 }
 
-void VocalCompressorAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+template <typename ValueOf>
+VocalDSP::Bands VocalCompressorAudioProcessor::getBands (ValueOf&& valueOf) const
 {
+    VocalDSP::Bands split;
+    const int bandsIndex = (int) valueOf (*bands);
+    split.numBands = bandsIndex == 0 ? 0 : bandsIndex + 1;
+    
+    for (size_t k = 0; k < crossovers.size(); ++k)
+        split.crossovers[k] = valueOf (*crossovers[k]);
+    
+    for (size_t band = 0; band < bandThresholds.size(); ++band)
+        split.thresholdOffsets[band] = valueOf (*bandThresholds[band]);
+    
+    return split;
+}
+
+VocalDSP::Bands VocalCompressorAudioProcessor::getBands() const
+{
+    return getBands ([] (const auto& parameter) { return (float) parameter; });
+}
+
+VocalDSP::Bands VocalCompressorAudioProcessor::getBands (const ParameterSnapshot& snapshot) const
+{
+    return getBands ([&snapshot] (const juce::AudioProcessorParameter& parameter) { return snapshot[parameter]; });
+}
+
+bool VocalCompressorAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
+template <typename SampleType>
+void VocalCompressorAudioProcessor::process (juce::AudioBuffer<SampleType>& buffer, Engine<SampleType>& engine)
+{
+   #if VOCALCOMPRESSOR_INSTRUMENTATION
+    const Instrumentation::ScopedBlock instrumentedBlock (instrumentation, buffer.getNumSamples());
+   #endif
+    
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
@@ -189,22 +326,88 @@ void VocalCompressorAudioProcessor::processBlock (juce::AudioBuffer<float>& buff
     // this code if your algorithm always overwrites all the output channels.
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
-    juce::dsp::AudioBlock<float> block (buffer);
-    auto context = juce::dsp::ProcessContextReplacing<float> (block);
 
-    envelopeFilter.setAttackTime(*attack);
-    envelopeFilter.setReleaseTime(*release);
+    // Until a program switch has been taken up at a block boundary, its snapshot supplies every parameter of the block
+    const auto* program = takeProgramSwitch();
     
-    for (int channel = 0; channel < block.getNumChannels(); channel++)
+    const int numStages = program != nullptr ? (int) (*program)[*oversampling] : oversampling->getIndex();
+    auto& kernel = engine.kernels[(size_t) numStages];
+    auto& multibandKernel = engine.multibands[(size_t) numStages];
+    
+    const auto split = program != nullptr ? getBands (*program) : getBands();
+    const bool multiband = split.numBands > 0;
+    
+    // A kernel taking over starts from silence, the oversampler clears its own filters
+    if (numStages != engine.numStages || multiband != engine.multiband)
     {
-        float* samples  = block.getChannelPointer(channel);
-        for (int i = 0; i < block.getNumSamples(); ++i)
-            samples[i] = processSample(channel, samples[i]);
+        if (multiband)
+            multibandKernel.reset();
+        else
+            kernel.reset();
+        
+        engine.numStages = numStages;
+        engine.multiband = multiband;
     }
     
-    gain.setGainDecibels(-getGainReduction(-0.0f) * *autoGain);
-    gain.process(context);
+    // Levels are only gathered while an editor is showing them
+    const bool metering = meterFeed.isActive();
+    kernel.setMeteringEnabled (metering && ! multiband);
+    multibandKernel.setMeteringEnabled (metering && multiband);
+
+    auto parameters = program != nullptr ? getKernelParameters (*program) : getKernelParameters();
     
+    // Whole samples of lookahead at the base rate, so the latency stays whole
+    if (numStages > 0)
+        parameters.lookahead = (float) (engine.kernels[0].getLookaheadSamples (parameters.lookahead) * 1000.0 / getSampleRate());
+    
+    typename VocalDSP::CompressorKernel<SampleType>::Levels levels;
+
+    // Parameters are read once per block, the kernel runs each stage over
+    // the whole block instead of the full chain per sample, ramping the curve
+    // over it when the host moved threshold, ratio, knee or auto gain.
+    // Oversampled, it runs on the upsampled channels instead.
+    engine.oversampler.process (buffer.getArrayOfWritePointers(), buffer.getNumChannels(), buffer.getNumSamples(),
+                                numStages, [&] (SampleType* const* channels, int numChannels, int numSamples)
+    {
+        if (multiband)
+            multibandKernel.process (channels, numChannels, numSamples, parameters, split);
+        else
+            kernel.process (channels, numChannels, numSamples, parameters);
+        
+        if (metering)
+        {
+            const auto& blockLevels = multiband ? multibandKernel.getLevels() : kernel.getLevels();
+            
+            if (levels.numSamples == 0)
+                levels = blockLevels;
+            else
+                levels.add (blockLevels);
+        }
+    });
+
+    if (metering)
+        meterFeed.push (levels);
+
+    // A new lookahead or factor changes the latency, which the host is told about from the message thread.
+    // The multiband mode has no lookahead.
+    const int latency = VocalDSP::Oversampler<SampleType>::getLatencySamples (numStages)
+                      + (multiband ? 0 : kernel.getLatencySamples() >> numStages);
+    
+    if (latency != latencySamples.load (std::memory_order_relaxed))
+    {
+        latencySamples.store (latency, std::memory_order_relaxed);
+        triggerAsyncUpdate();
+    }
+}
+
+void VocalCompressorAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    process (buffer, floatEngine);
+}
+
+void VocalCompressorAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    process (buffer, doubleEngine);
 }
 
 //==============================================================================
@@ -221,35 +424,29 @@ juce::AudioProcessorEditor* VocalCompressorAudioProcessor::createEditor()
 //==============================================================================
 void VocalCompressorAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
-    std::unique_ptr<juce::XmlElement> xml (new juce::XmlElement ("VocalCompressorParameter"));
-    xml->setAttribute ("threshold", (double) *threshold);
-    xml->setAttribute ("ratio", (double) *ratio);
-    xml->setAttribute ("attack", (double) *attack);
-    xml->setAttribute ("release", (double) *release);
-    xml->setAttribute ("knee", (double) *knee);
-    xml->setAttribute ("autoGain", (double) *autoGain);
-    copyXmlToBinary (*xml, destData);
+    // The compact binary form, see ParameterSnapshot.h
+    ParameterSnapshot::fromParameters (getParameters()).writeBinary (destData, getParameters());
 }
 
 void VocalCompressorAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
+    const auto& parameters = getParameters();
+    auto snapshot = ParameterSnapshot::fromParameters (parameters);
+    
+    if (snapshot.readBinary (data, sizeInBytes, parameters))
+    {
+        snapshot.applyTo (parameters);
+        return;
+    }
+    
+    // Sessions saved before the binary state hold the parameters as XML attributes named by ID
     std::unique_ptr<juce::XmlElement> xmlState (getXmlFromBinary (data, sizeInBytes));
 
-    if (xmlState.get() != nullptr)
-        if (xmlState->hasTagName ("VocalCompressorParameter"))
-        {
-            *threshold = (float) xmlState->getDoubleAttribute ("threshold", *threshold);
-            *ratio = (float) xmlState->getDoubleAttribute ("ratio", *ratio);
-            *attack = (float) xmlState->getDoubleAttribute ("attack", *attack);
-            *release = (float) xmlState->getDoubleAttribute ("release", *release);
-            *knee = (float) xmlState->getDoubleAttribute ("knee", *knee);
-            *autoGain = (float) xmlState->getDoubleAttribute ("autoGain", *autoGain);
-        }
+    if (xmlState != nullptr && xmlState->hasTagName ("VocalCompressorParameter"))
+    {
+        snapshot.setFrom (ParameterSnapshot::getAttributes (*xmlState), parameters);
+        snapshot.applyTo (parameters);
+    }
 }
 
 //==============================================================================
@@ -9,11 +9,19 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "DSP/CompressorKernel.h"
+#include "DSP/MultibandCompressor.h"
+#include "DSP/Oversampler.h"
+#include "MeterFeed.h"
+#include "Instrumentation.h"
+#include "ParameterSnapshot.h"
+#include "PresetBank.h"
 
 //==============================================================================
 /**
 */
-class VocalCompressorAudioProcessor  : public juce::AudioProcessor
+class VocalCompressorAudioProcessor  : public juce::AudioProcessor,
+                                       private juce::AsyncUpdater
 {
 public:
     //==============================================================================
@@ -24,8 +32,27 @@ public:
     juce::AudioParameterFloat*  ratio;
     juce::AudioParameterFloat*  attack;
     juce::AudioParameterFloat*  release;
+    juce::AudioParameterFloat*  lookahead;
     juce::AudioParameterFloat*  knee;
     juce::AudioParameterFloat*  autoGain;
+    juce::AudioParameterChoice* autoGainMode;
+    juce::AudioParameterFloat*  autoGainSmoothing;
+    juce::AudioParameterChoice* accuracy;
+    juce::AudioParameterChoice* controlRate;
+    juce::AudioParameterChoice* link;
+    juce::AudioParameterChoice* detector;
+    juce::AudioParameterChoice* oversampling;
+    juce::AudioParameterChoice* bands;
+    std::array<juce::AudioParameterFloat*, VocalDSP::Bands::maximumBands - 1> crossovers;
+    std::array<juce::AudioParameterFloat*, VocalDSP::Bands::maximumBands> bandThresholds;
+    
+    /** Block levels for the editor's meters. */
+    MeterFeed meterFeed;
+    
+   #if VOCALCOMPRESSOR_INSTRUMENTATION
+    /** Block timings, allocations and locks on the audio thread, for the editor's debug panel. */
+    Instrumentation instrumentation;
+   #endif
     
     //==============================================================================
     void prepareToPlay (double sampleRate, int samplesPerBlock) override;
@@ -35,7 +62,10 @@ public:
     bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
    #endif
 
+    bool supportsDoublePrecisionProcessing() const override;
+
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -62,11 +92,66 @@ public:
 
 private:
     
-    float getGainReduction (float env);
-    float processSample (int channel, float sample);
+    /** The kernel's parameters, from the live values or from a snapshot. */
+    VocalDSP::Parameters getKernelParameters() const;
+    VocalDSP::Parameters getKernelParameters (const ParameterSnapshot&) const;
+    
+    template <typename ValueOf>
+    VocalDSP::Parameters getKernelParameters (ValueOf&& valueOf) const;
+    
+    /** The band split, with numBands 0 when the multiband mode is off. */
+    VocalDSP::Bands getBands() const;
+    VocalDSP::Bands getBands (const ParameterSnapshot&) const;
+    
+    template <typename ValueOf>
+    VocalDSP::Bands getBands (ValueOf&& valueOf) const;
+    
+    void handleAsyncUpdate() override;
+    
+    /** Everything that processes one sample type. Only the engine for the
+        precision the host picked is prepared.
+    */
+    template <typename SampleType>
+    struct Engine
+    {
+        // One kernel and one multiband engine per oversampling factor, each prepared for its own rate
+        std::array<VocalDSP::CompressorKernel<SampleType>, VocalDSP::Oversampler<SampleType>::maximumStages + 1> kernels;
+        std::array<VocalDSP::MultibandCompressor<SampleType>, VocalDSP::Oversampler<SampleType>::maximumStages + 1> multibands;
+        VocalDSP::Oversampler<SampleType> oversampler;
+        int numStages = 0;
+        bool multiband = false;
+        
+        void prepare (double sampleRate, int maximumBlockSize, int numChannels);
+    };
+    
+    template <typename SampleType>
+    void process (juce::AudioBuffer<SampleType>& buffer, Engine<SampleType>& engine);
+    
+    Engine<float> floatEngine;
+    Engine<double> doubleEngine;
+    
+    std::atomic<int> latencySamples { 0 };
+    
+    // Shared by every instance, the snapshots are this instance's own
+    juce::SharedResourcePointer<PresetBank> presetBank;
+    std::vector<ParameterSnapshot> programs;
+    int currentProgram = 0;
+    
+    /** The program setCurrentProgram() is moving the parameters to, as
+        generation << 32 | (index + 1) << 1 | applied, or 0 when there is none.
+
+        From the moment a switch starts, blocks take every parameter from the
+        program's snapshot instead of the live parameters. The snapshot stays
+        published after the parameters have been applied, until a block that
+        started after that takes it one last time and withdraws it, so no
+        block sees a mix of the old and new program. The generation keeps a
+        block from withdrawing a later switch to the same program.
+    */
+    std::atomic<juce::uint64> programSwitch { 0 };
+    juce::uint32 programSwitchGeneration = 0;   // message thread only
     
-    juce::dsp::BallisticsFilter<float> envelopeFilter;
-    juce::dsp::Gain<float> gain;
+    /** Returns the snapshot a starting block reads its parameters from, or nullptr for the live ones. */
+    const ParameterSnapshot* takeProgramSwitch() noexcept;
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (VocalCompressorAudioProcessor)
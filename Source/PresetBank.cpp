@@ -0,0 +1,52 @@
+/*
+  ==============================================================================
+
+    PresetBank.cpp
+
+  ==============================================================================
+*/
+
+#include "PresetBank.h"
+#include "ParameterSnapshot.h"
+
+namespace
+{
+    // Attributes left out fall back to the parameter defaults
+    const char* const factoryPresets = R"(
+<VocalCompressorPresets>
+  <VocalCompressorParameter name="Default"/>
+  <VocalCompressorParameter name="Gentle Leveling" threshold="-26" ratio="2" attack="10"
+                            release="400" knee="24" autoGain="1" autoGainMode="1"
+                            autoGainSmoothing="3000" detector="1"/>
+  <VocalCompressorParameter name="Podcast Voice" threshold="-20" ratio="3" attack="5"
+                            release="200" knee="12" autoGain="0.8" autoGainMode="1"/>
+  <VocalCompressorParameter name="Upfront Vocal" threshold="-30" ratio="6" attack="2"
+                            release="120" knee="6" autoGain="1" detector="2"/>
+  <VocalCompressorParameter name="Dialogue Stem" threshold="-22" ratio="3" attack="5"
+                            release="300" knee="18" autoGain="1" autoGainMode="1"
+                            link="2" detector="1"/>
+  <VocalCompressorParameter name="Peak Catcher" threshold="-8" ratio="20" attack="0"
+                            release="80" knee="3" autoGain="0" lookahead="5"
+                            oversampling="2"/>
+</VocalCompressorPresets>
+)";
+}
+
+//==============================================================================
+PresetBank::PresetBank()
+{
+    auto xml = juce::XmlDocument::parse (factoryPresets);
+    jassert (xml != nullptr);
+
+    if (xml == nullptr)
+        return;
+
+    for (auto* element : xml->getChildWithTagNameIterator ("VocalCompressorParameter"))
+    {
+        Preset preset;
+        preset.name = element->getStringAttribute ("name");
+        preset.values = ParameterSnapshot::getAttributes (*element);
+        preset.values.remove ("name");
+        presets.push_back (std::move (preset));
+    }
+}
@@ -0,0 +1,41 @@
+/*
+  ==============================================================================
+
+    PresetBank.h
+
+    The factory presets, in the same XML form as the plugin's old state and
+    the batch renderer's presets. The XML is parsed once per process: every
+    instance holds the bank through a juce::SharedResourcePointer, and turns
+    the parsed values into snapshots of its own parameters when it is
+    created, so neither loading nor switching programs touches XML again.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <vector>
+
+//==============================================================================
+class PresetBank
+{
+public:
+    PresetBank();
+
+    struct Preset
+    {
+        juce::String name;
+
+        /** Parameter values keyed by parameter ID, for ParameterSnapshot::setFrom(). */
+        juce::NamedValueSet values;
+    };
+
+    const std::vector<Preset>& getPresets() const noexcept  { return presets; }
+
+private:
+    std::vector<Preset> presets;
+
+    JUCE_DECLARE_NON_COPYABLE (PresetBank)
+};
@@ -0,0 +1,110 @@
+/*
+  ==============================================================================
+
+    TransferCurveDisplay.cpp
+
+  ==============================================================================
+*/
+
+#include "TransferCurveDisplay.h"
+
+namespace
+{
+    // Both axes, in dBFS
+    constexpr float rangeDb = 60.0f;
+    constexpr float gridDb = 12.0f;
+}
+
+//==============================================================================
+TransferCurveDisplay::TransferCurveDisplay (juce::RangedAudioParameter& threshold, juce::RangedAudioParameter& ratio,
+                                            juce::RangedAudioParameter& knee, juce::Colour line,
+                                            juce::Colour grid, juce::Colour background)
+    : curveColour (line), gridColour (grid), backgroundColour (background),
+      thresholdAttachment (threshold, [this] (float value) { auto c = curve; c.threshold = value; setCurve (c); }),
+      ratioAttachment (ratio, [this] (float value) { auto c = curve; c.ratio = value; setCurve (c); }),
+      kneeAttachment (knee, [this] (float value) { auto c = curve; c.knee = value; setCurve (c); })
+{
+    setOpaque (true);
+
+    thresholdAttachment.sendInitialUpdate();
+    ratioAttachment.sendInitialUpdate();
+    kneeAttachment.sendInitialUpdate();
+}
+
+void TransferCurveDisplay::setCurve (const VocalDSP::GainCurve& newCurve)
+{
+    if (newCurve == curve && imageIsValid)
+        return;
+
+    curve = newCurve;
+    imageIsValid = false;
+    repaint();
+}
+
+//==============================================================================
+void TransferCurveDisplay::paint (juce::Graphics& g)
+{
+    if (! imageIsValid)
+        renderCurve();
+
+    g.drawImageAt (image, 0, 0);
+}
+
+void TransferCurveDisplay::resized()
+{
+    imageIsValid = false;
+}
+
+void TransferCurveDisplay::renderCurve()
+{
+    const int width = juce::jmax (1, getWidth());
+    const int height = juce::jmax (1, getHeight());
+
+    if (image.getWidth() != width || image.getHeight() != height)
+        image = juce::Image (juce::Image::RGB, width, height, false);
+
+    juce::Graphics g (image);
+    g.fillAll (backgroundColour);
+
+    const auto xScale = (float) width / rangeDb;
+    const auto yScale = (float) height / rangeDb;
+
+    g.setColour (gridColour);
+
+    for (float decibels = gridDb; decibels < rangeDb; decibels += gridDb)
+    {
+        g.drawVerticalLine (juce::roundToInt (decibels * xScale), 0.0f, (float) height);
+        g.drawHorizontalLine (juce::roundToInt (decibels * yScale), 0.0f, (float) width);
+    }
+
+    // Unity gain, for reference
+    g.drawLine (0.0f, (float) height, (float) width, 0.0f);
+
+    // One input level per column, run through the kernel's own curve
+    levels.resize ((size_t) width);
+    gains.resize ((size_t) width);
+
+    for (int x = 0; x < width; ++x)
+        levels[(size_t) x] = ((float) x + 0.5f) / xScale - rangeDb;
+
+    curveTable.update (curve);
+    VocalDSP::CompressorKernel<float>::computeGain (levels.data(), gains.data(), width, curveTable, 0.0f);
+
+    juce::Path path;
+
+    for (int x = 0; x < width; ++x)
+    {
+        const auto output = levels[(size_t) x] + gains[(size_t) x];
+        const auto y = -output * yScale;
+
+        if (x == 0)
+            path.startNewSubPath ((float) x + 0.5f, y);
+        else
+            path.lineTo ((float) x + 0.5f, y);
+    }
+
+    g.setColour (curveColour);
+    g.strokePath (path, juce::PathStrokeType (2.0f));
+
+    imageIsValid = true;
+}
@@ -0,0 +1,49 @@
+/*
+  ==============================================================================
+
+    TransferCurveDisplay.h
+
+    The static input to output curve. It is drawn from the same
+    GainCurveTable and CompressorKernel::computeGain() the audio thread uses,
+    into a cached image that is only redrawn when the threshold, ratio or
+    knee changes, or the component is resized. Every other repaint is a blit.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "DSP/CompressorKernel.h"
+
+//==============================================================================
+class TransferCurveDisplay  : public juce::Component
+{
+public:
+    TransferCurveDisplay (juce::RangedAudioParameter& threshold, juce::RangedAudioParameter& ratio,
+                          juce::RangedAudioParameter& knee, juce::Colour curveColour,
+                          juce::Colour gridColour, juce::Colour backgroundColour);
+
+    //==============================================================================
+    void paint (juce::Graphics&) override;
+    void resized() override;
+
+private:
+    void setCurve (const VocalDSP::GainCurve& newCurve);
+    void renderCurve();
+
+    const juce::Colour curveColour, gridColour, backgroundColour;
+
+    VocalDSP::GainCurve curve;
+    VocalDSP::GainCurveTable<float> curveTable;
+
+    juce::Image image;
+    bool imageIsValid = false;
+
+    // One input level and gain per pixel column
+    std::vector<float> levels, gains;
+
+    juce::ParameterAttachment thresholdAttachment, ratioAttachment, kneeAttachment;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TransferCurveDisplay)
+};
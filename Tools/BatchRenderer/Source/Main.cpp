@@ -0,0 +1,412 @@
+/*
+  ==============================================================================
+
+    Headless batch renderer for the Vocal Compressor.
+
+    Runs the plugin's DSP core over WAV/AIFF files without a host, one file
+    per worker thread, streaming each file through in large blocks.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+
+#include "../../../Source/DSP/CompressorKernel.h"
+#include "../../../Source/DSP/MultibandCompressor.h"
+#include "../../../Source/DSP/Oversampler.h"
+
+//==============================================================================
+static void printUsage()
+{
+    std::cout << "Usage: VocalCompressorBatch [options] <file> [file...]\n"
+                 "\n"
+                 "Options:\n"
+                 "  --preset=<file>          parameters from an XML preset (VocalCompressorParameter)\n"
+                 "  --threshold=<dBFS>       default -18\n"
+                 "  --ratio=<n>              default 4\n"
+                 "  --attack=<ms>            default 5\n"
+                 "  --release=<ms>           default 250\n"
+                 "  --lookahead=<ms>         0 to 10, default 0; the output stays aligned with the input\n"
+                 "  --knee=<dB>              default 18\n"
+                 "  --autogain=<0..1>        default 0.5\n"
+                 "  --autogain-mode=<mode>   curve or loudness, default curve\n"
+                 "  --autogain-smoothing=<ms> time constant of the loudness mode, default 2000\n"
+                 "  --accuracy=<mode>        exact, high or fast, default high\n"
+                 "  --control-rate=<n>       1, 8, 16 or 32 samples per gain update, default 1\n"
+                 "  --link=<mode>            unlinked, max or rms, default unlinked\n"
+                 "  --detector=<type>        peak, rms or log, default peak\n"
+                 "  --oversampling=<n>       1, 2, 4 or 8, default 1; the output stays aligned with the input\n"
+                 "  --bands=<n>              1 to 4, default 1; more than one band ignores the lookahead,\n"
+                 "                           control rate, link, detector and loudness make-up\n"
+                 "  --crossovers=<Hz,...>    the band edges, default 250,2500,7000\n"
+                 "  --band-offsets=<dB,...>  added to the threshold of each band, default 0\n"
+                 "  --output-dir=<dir>       default: next to the input, with a _compressed suffix\n"
+                 "  --threads=<n>            default: one per core\n"
+                 "  --block-size=<n>         samples per read, default 65536\n"
+                 "\n"
+                 "Command line values override the preset.\n";
+}
+
+//==============================================================================
+static bool loadPreset (const juce::File& file, VocalDSP::Parameters& parameters, int& numStages, VocalDSP::Bands& bands)
+{
+    auto xml = juce::XmlDocument::parse (file);
+
+    if (xml == nullptr || ! xml->hasTagName ("VocalCompressorParameter"))
+        return false;
+
+    parameters.threshold = (float) xml->getDoubleAttribute ("threshold", parameters.threshold);
+    parameters.ratio = (float) xml->getDoubleAttribute ("ratio", parameters.ratio);
+    parameters.attack = (float) xml->getDoubleAttribute ("attack", parameters.attack);
+    parameters.release = (float) xml->getDoubleAttribute ("release", parameters.release);
+    parameters.lookahead = (float) xml->getDoubleAttribute ("lookahead", parameters.lookahead);
+    parameters.knee = (float) xml->getDoubleAttribute ("knee", parameters.knee);
+    parameters.autoGain = (float) xml->getDoubleAttribute ("autoGain", parameters.autoGain);
+    parameters.makeUp = (VocalDSP::MakeUp) juce::jlimit (0, 1, xml->getIntAttribute ("autoGainMode", (int) parameters.makeUp));
+    parameters.makeUpSmoothing = (float) xml->getDoubleAttribute ("autoGainSmoothing", parameters.makeUpSmoothing);
+    parameters.accuracy = (VocalDSP::Accuracy) juce::jlimit (0, 2, xml->getIntAttribute ("accuracy", (int) parameters.accuracy));
+
+    // Same choice indices as the plugin's Control Rate parameter
+    const int controlRate = juce::jlimit (0, 3, xml->getIntAttribute ("controlRate", 0));
+    parameters.controlInterval = controlRate == 0 ? 1 : 4 << controlRate;
+    parameters.link = (VocalDSP::Link) juce::jlimit (0, 2, xml->getIntAttribute ("link", 0));
+    parameters.detector = (VocalDSP::Detector) juce::jlimit (0, 2, xml->getIntAttribute ("detector", 0));
+
+    // The Oversampling choice index is the number of stages
+    numStages = juce::jlimit (0, VocalDSP::Oversampler<float>::maximumStages, xml->getIntAttribute ("oversampling", numStages));
+
+    // The Bands choice is Off, 2, 3 or 4
+    const int bandsIndex = juce::jlimit (0, VocalDSP::Bands::maximumBands - 1, xml->getIntAttribute ("bands", 0));
+    bands.numBands = bandsIndex == 0 ? 0 : bandsIndex + 1;
+
+    for (size_t k = 0; k < bands.crossovers.size(); ++k)
+        bands.crossovers[k] = (float) xml->getDoubleAttribute ("crossover" + juce::String ((int) k + 1), bands.crossovers[k]);
+
+    for (size_t band = 0; band < bands.thresholdOffsets.size(); ++band)
+        bands.thresholdOffsets[band] = (float) xml->getDoubleAttribute ("bandThreshold" + juce::String ((int) band + 1), bands.thresholdOffsets[band]);
+
+    return true;
+}
+
+static void applyOption (const juce::ArgumentList& args, const juce::String& option, float& value)
+{
+    if (args.containsOption (option))
+        value = args.getValueForOption (option).getFloatValue();
+}
+
+/** A comma separated list, filling as many values as it has. */
+template <size_t size>
+static void applyOption (const juce::ArgumentList& args, const juce::String& option, std::array<float, size>& values)
+{
+    if (! args.containsOption (option))
+        return;
+
+    const auto tokens = juce::StringArray::fromTokens (args.getValueForOption (option), ",", {});
+
+    for (int i = 0; i < juce::jmin (tokens.size(), (int) size); ++i)
+        values[(size_t) i] = tokens[i].getFloatValue();
+}
+
+//==============================================================================
+struct RenderResult
+{
+    bool succeeded = false;
+    juce::String message;
+    juce::int64 numSamples = 0;     // per channel
+    int numChannels = 0;
+    double seconds = 0.0;
+};
+
+static RenderResult renderFile (const juce::File& input, const juce::File& output,
+                                const VocalDSP::Parameters& parameters, int numStages, const VocalDSP::Bands& bands,
+                                int blockSize)
+{
+    RenderResult result;
+    const auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor (input));
+
+    if (reader == nullptr)
+    {
+        result.message = "unsupported or unreadable file";
+        return result;
+    }
+
+    auto* format = formatManager.findFormatForFileExtension (output.getFileExtension());
+
+    if (format == nullptr)
+    {
+        result.message = "no writer for " + output.getFileExtension();
+        return result;
+    }
+
+    output.deleteFile();
+    std::unique_ptr<juce::OutputStream> stream (output.createOutputStream());
+
+    if (stream == nullptr)
+    {
+        result.message = "cannot write " + output.getFullPathName();
+        return result;
+    }
+
+    const int numChannels = (int) reader->numChannels;
+
+    std::unique_ptr<juce::AudioFormatWriter> writer (format->createWriterFor (stream.get(), reader->sampleRate,
+                                                                              (unsigned int) numChannels,
+                                                                              (int) reader->bitsPerSample,
+                                                                              reader->metadataValues, 0));
+    if (writer == nullptr)
+    {
+        result.message = "cannot create a writer for this format";
+        return result;
+    }
+
+    stream.release(); // now owned by the writer
+
+    VocalDSP::CompressorKernel<float> kernel;
+    kernel.prepare (reader->sampleRate * (1 << numStages), blockSize << numStages, numChannels);
+
+    // Only prepared when it is used
+    const bool multiband = bands.numBands > 1;
+    VocalDSP::MultibandCompressor<float> multibandKernel;
+
+    if (multiband)
+        multibandKernel.prepare (reader->sampleRate * (1 << numStages), blockSize << numStages, numChannels);
+
+    VocalDSP::Oversampler<float> oversampler;
+    oversampler.prepare (blockSize, numChannels);
+
+    juce::AudioBuffer<float> buffer (numChannels, blockSize);
+
+    // Whole samples of lookahead at the file's rate, as in the plugin, where the multiband mode has none
+    const auto lookaheadMs = multiband ? 0.0f : juce::jlimit (0.0f, VocalDSP::CompressorKernel<float>::maximumLookaheadMs, parameters.lookahead);
+    const int lookahead = (int) std::round (reader->sampleRate * lookaheadMs / 1000.0);
+
+    auto kernelParameters = parameters;
+    kernelParameters.lookahead = (float) (lookahead * 1000.0 / reader->sampleRate);
+
+    // The loudness make-up gain moves once per kernel call, so call it as
+    // often as a host would rather than once per read
+    const int kernelBlockSize = parameters.makeUp == VocalDSP::MakeUp::loudness ? juce::jmin (blockSize, 1024) << numStages
+                                                                                : blockSize << numStages;
+    std::vector<float*> kernelChannels ((size_t) numChannels);
+
+    // Drop the lookahead and oversampling delay from the start and flush it out at
+    // the end, reading past the end of the file gives silence
+    const int latency = lookahead + VocalDSP::Oversampler<float>::getLatencySamples (numStages);
+    const auto length = reader->lengthInSamples + latency;
+    int toSkip = latency;
+
+    for (juce::int64 position = 0; position < length; position += blockSize)
+    {
+        const int n = (int) juce::jmin ((juce::int64) blockSize, length - position);
+
+        reader->read (&buffer, 0, n, position, true, true);
+        oversampler.process (buffer.getArrayOfWritePointers(), numChannels, n, numStages,
+                             [&] (float* const* channels, int numOversampledChannels, int numSamples)
+        {
+            for (int offset = 0; offset < numSamples; offset += kernelBlockSize)
+            {
+                for (int channel = 0; channel < numOversampledChannels; ++channel)
+                    kernelChannels[(size_t) channel] = channels[channel] + offset;
+
+                const int numKernelSamples = juce::jmin (kernelBlockSize, numSamples - offset);
+
+                if (multiband)
+                    multibandKernel.process (kernelChannels.data(), numOversampledChannels, numKernelSamples, kernelParameters, bands);
+                else
+                    kernel.process (kernelChannels.data(), numOversampledChannels, numKernelSamples, kernelParameters);
+            }
+        });
+
+        const int skipped = juce::jmin (toSkip, n);
+        toSkip -= skipped;
+
+        if (n > skipped && ! writer->writeFromAudioSampleBuffer (buffer, skipped, n - skipped))
+        {
+            result.message = "write failed";
+            return result;
+        }
+    }
+
+    result.succeeded = true;
+    result.numSamples = reader->lengthInSamples;
+    result.numChannels = numChannels;
+    result.seconds = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+    return result;
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ArgumentList args (argc, argv);
+
+    if (args.size() == 0 || args.containsOption ("--help|-h"))
+    {
+        printUsage();
+        return args.size() == 0 ? 1 : 0;
+    }
+
+    VocalDSP::Parameters parameters;
+    int numStages = 0;
+
+    VocalDSP::Bands bands;
+    bands.numBands = 0;
+
+    if (args.containsOption ("--preset"))
+    {
+        const auto presetFile = args.getFileForOption ("--preset");
+
+        if (! presetFile.existsAsFile() || ! loadPreset (presetFile, parameters, numStages, bands))
+        {
+            std::cerr << "Not a Vocal Compressor preset: " << presetFile.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+
+    applyOption (args, "--threshold", parameters.threshold);
+    applyOption (args, "--ratio", parameters.ratio);
+    applyOption (args, "--attack", parameters.attack);
+    applyOption (args, "--release", parameters.release);
+    applyOption (args, "--lookahead", parameters.lookahead);
+    applyOption (args, "--knee", parameters.knee);
+    applyOption (args, "--autogain", parameters.autoGain);
+    applyOption (args, "--autogain-smoothing", parameters.makeUpSmoothing);
+
+    if (args.containsOption ("--autogain-mode"))
+        parameters.makeUp = args.getValueForOption ("--autogain-mode") == "loudness" ? VocalDSP::MakeUp::loudness
+                                                                                     : VocalDSP::MakeUp::curve;
+
+    if (args.containsOption ("--accuracy"))
+    {
+        const auto mode = args.getValueForOption ("--accuracy");
+        parameters.accuracy = mode == "exact" ? VocalDSP::Accuracy::exact
+                            : mode == "fast"  ? VocalDSP::Accuracy::fast
+                                              : VocalDSP::Accuracy::high;
+    }
+
+    if (args.containsOption ("--control-rate"))
+        parameters.controlInterval = args.getValueForOption ("--control-rate").getIntValue();
+
+    if (args.containsOption ("--link"))
+    {
+        const auto mode = args.getValueForOption ("--link");
+        parameters.link = mode == "max" ? VocalDSP::Link::max
+                        : mode == "rms" ? VocalDSP::Link::rms
+                                        : VocalDSP::Link::unlinked;
+    }
+
+    if (args.containsOption ("--detector"))
+    {
+        const auto type = args.getValueForOption ("--detector");
+        parameters.detector = type == "rms" ? VocalDSP::Detector::rms
+                            : type == "log" ? VocalDSP::Detector::logarithmic
+                                            : VocalDSP::Detector::peak;
+    }
+
+    if (args.containsOption ("--oversampling"))
+    {
+        const int factor = args.getValueForOption ("--oversampling").getIntValue();
+        numStages = factor >= 8 ? 3 : factor >= 4 ? 2 : factor >= 2 ? 1 : 0;
+    }
+
+    if (args.containsOption ("--bands"))
+    {
+        const int numBands = juce::jlimit (1, VocalDSP::Bands::maximumBands, args.getValueForOption ("--bands").getIntValue());
+        bands.numBands = numBands > 1 ? numBands : 0;
+    }
+
+    applyOption (args, "--crossovers", bands.crossovers);
+    applyOption (args, "--band-offsets", bands.thresholdOffsets);
+
+    const int blockSize = args.containsOption ("--block-size")
+                            ? juce::jmax (64, args.getValueForOption ("--block-size").getIntValue())
+                            : 65536;
+
+    const int numThreads = args.containsOption ("--threads")
+                             ? juce::jmax (1, args.getValueForOption ("--threads").getIntValue())
+                             : juce::SystemStats::getNumCpus();
+
+    juce::File outputDirectory;
+
+    if (args.containsOption ("--output-dir"))
+    {
+        outputDirectory = args.getFileForOption ("--output-dir");
+        outputDirectory.createDirectory();
+    }
+
+    juce::Array<juce::File> inputs;
+
+    for (auto& arg : args.arguments)
+        if (! arg.isOption())
+            inputs.add (arg.resolveAsFile());
+
+    if (inputs.isEmpty())
+    {
+        printUsage();
+        return 1;
+    }
+
+    //==============================================================================
+    juce::ThreadPool pool (juce::jmin (numThreads, inputs.size()));
+    juce::CriticalSection outputLock;
+    std::atomic<juce::int64> totalSamples { 0 };
+    std::atomic<int> numFailed { 0 };
+
+    const auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+    for (auto& input : inputs)
+    {
+        const auto output = outputDirectory != juce::File()
+                              ? outputDirectory.getChildFile (input.getFileName())
+                              : input.getSiblingFile (input.getFileNameWithoutExtension() + "_compressed" + input.getFileExtension());
+
+        pool.addJob ([=, &outputLock, &totalSamples, &numFailed]
+        {
+            RenderResult result;
+
+            if (! input.existsAsFile())
+                result.message = "file not found";
+            else if (output == input)
+                result.message = "output would overwrite the input";
+            else
+                result = renderFile (input, output, parameters, numStages, bands, blockSize);
+
+            const juce::ScopedLock sl (outputLock);
+
+            if (result.succeeded)
+            {
+                const auto samples = result.numSamples * result.numChannels;
+                totalSamples += samples;
+
+                std::cout << input.getFileName() << " -> " << output.getFullPathName()
+                          << "  (" << juce::String ((double) samples / juce::jmax (result.seconds, 1.0e-9) / 1.0e6, 1)
+                          << " M samples/s)" << std::endl;
+            }
+            else
+            {
+                ++numFailed;
+                std::cerr << input.getFileName() << ": " << result.message << std::endl;
+            }
+
+            return juce::ThreadPoolJob::jobHasFinished;
+        });
+    }
+
+    while (pool.getNumJobs() > 0)
+        juce::Thread::sleep (20);
+
+    const double seconds = (juce::Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+
+    std::cout << inputs.size() - numFailed << " of " << inputs.size() << " files, "
+              << totalSamples.load() << " samples in " << juce::String (seconds, 2) << " s on "
+              << pool.getNumThreads() << " threads: "
+              << juce::String ((double) totalSamples.load() / juce::jmax (seconds, 1.0e-9) / 1.0e6, 1)
+              << " M samples/s" << std::endl;
+
+    return numFailed > 0 ? 1 : 0;
+}
@@ -0,0 +1,163 @@
+"""
+Generates the golden reference files for the benchmark's --golden mode.
+
+The reference is the model in Resources/Dynamic Range Compression.ipynb
+itself: the cells defining decibels_to_gain, gain_to_decibels,
+get_gain_reduction and process_sample are executed as they are, and
+process_sample is run over every signal for every curve in CURVES. The
+notebook model has no ballistics, so the C++ side is run with zero attack
+and release to match.
+
+Writes manifest.json and one pair of little endian float64 files per case
+into the output directory:
+
+    python3 generate_golden.py [output directory]
+
+Needs only the Python standard library.
+"""
+
+import json
+import math
+import os
+import random
+import struct
+import sys
+
+SAMPLE_RATE = 48000
+NUM_SAMPLES = SAMPLE_RATE
+
+# threshold (dBFS), ratio, knee (dB): the notebook's example, the plugin's
+# defaults, a hard knee and the extremes of the parameter ranges
+CURVES = [
+    (-20.0, 4.0, 6.0),
+    (-18.0, 4.0, 18.0),
+    (-30.0, 10.0, 0.0),
+    (-10.0, 1.5, 12.0),
+    (-60.0, 20.0, 96.0),
+]
+
+NOTEBOOK = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                        "..", "..", "..", "Resources", "Dynamic Range Compression.ipynb")
+
+
+def load_reference():
+    """Runs the notebook's model cells, skipping the imports and plots."""
+    with open(NOTEBOOK, encoding="utf-8") as file:
+        notebook = json.load(file)
+
+    namespace = {}
+
+    for cell in notebook["cells"]:
+        source = "".join(cell["source"])
+
+        if cell["cell_type"] == "code" and "def " in source and "%" not in source:
+            exec(source, namespace)
+
+    return namespace
+
+
+def level_ramp():
+    """A 1 kHz sine rising from -80 to +6 dBFS, through every part of the curve."""
+    signal = []
+
+    for i in range(NUM_SAMPLES):
+        level = -80.0 + 86.0 * i / NUM_SAMPLES
+        signal.append(10 ** (level / 20) * math.sin(2 * math.pi * 1000.0 * i / SAMPLE_RATE))
+
+    return signal
+
+
+def level_steps():
+    """Constant levels from -80 to +6 dBFS in 0.5 dB steps, alternating in sign."""
+    signal = []
+    steps = 173
+    length = NUM_SAMPLES // steps
+
+    for step in range(steps):
+        level = 10 ** ((-80.0 + 0.5 * step) / 20)
+        signal += [level if i % 2 == 0 else -level for i in range(length)]
+
+    return signal + [0.0] * (NUM_SAMPLES - len(signal))
+
+
+def bursts():
+    """Noise bursts between stretches of silence, for the below-knee fast path."""
+    generator = random.Random(17)
+    signal = []
+
+    for i in range(NUM_SAMPLES):
+        if (i // 2048) % 3 == 0:
+            gain = 10 ** (generator.uniform(-40.0, 0.0) / 20) if i % 2048 == 0 else gain
+            signal.append(gain * generator.uniform(-1.0, 1.0))
+        else:
+            signal.append(0.0)
+
+    return signal
+
+
+def speech_like():
+    """Noise under a syllable-rate envelope, with a few hard onsets."""
+    generator = random.Random(5)
+    signal = []
+
+    for i in range(NUM_SAMPLES):
+        t = i / SAMPLE_RATE
+        envelope = 0.5 * (1 + math.sin(2 * math.pi * 4.0 * t)) ** 2 / 4
+        onset = 0.9 if (i % 12000) < 64 else 0.0
+        signal.append(max(envelope, onset) * generator.gauss(0.0, 0.5))
+
+    return [max(-1.0, min(1.0, x)) for x in signal]
+
+
+SIGNALS = {
+    "levelRamp": level_ramp,
+    "levelSteps": level_steps,
+    "bursts": bursts,
+    "speechLike": speech_like,
+}
+
+
+def write_samples(path, samples):
+    with open(path, "wb") as file:
+        file.write(struct.pack("<%dd" % len(samples), *samples))
+
+
+def main():
+    directory = sys.argv[1] if len(sys.argv) > 1 else "golden"
+    os.makedirs(directory, exist_ok=True)
+
+    reference = load_reference()
+    cases = []
+
+    for signal_name, generate in SIGNALS.items():
+        signal = generate()
+        input_file = signal_name + ".input.f64"
+        write_samples(os.path.join(directory, input_file), signal)
+
+        for threshold, ratio, knee in CURVES:
+            # get_gain_reduction reads these as globals, like in the notebook
+            reference["threshold"], reference["ratio"], reference["knee"] = threshold, ratio, knee
+
+            name = "%s_%g_%g_%g" % (signal_name, threshold, ratio, knee)
+            output_file = name + ".golden.f64"
+            write_samples(os.path.join(directory, output_file),
+                          [reference["process_sample"](x) for x in signal])
+
+            cases.append({
+                "name": name,
+                "threshold": threshold,
+                "ratio": ratio,
+                "knee": knee,
+                "input": input_file,
+                "golden": output_file,
+            })
+
+    with open(os.path.join(directory, "manifest.json"), "w") as file:
+        json.dump({"version": 1, "sampleRate": SAMPLE_RATE, "numSamples": NUM_SAMPLES, "cases": cases},
+                  file, indent=2)
+
+    print("Wrote %d cases to %s" % (len(cases), directory))
+
+
+if __name__ == "__main__":
+    main()
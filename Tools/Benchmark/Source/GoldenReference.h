@@ -0,0 +1,127 @@
+/*
+  ==============================================================================
+
+    GoldenReference.h
+
+    Loads the golden files written by Golden/generate_golden.py from the
+    notebook model, and measures how far processed output is from them.
+
+    The error of a sample is the difference between the gain applied to it
+    and the gain the notebook applied, in dB. Samples whose input is at or
+    below -100 dBFS are left out, since the kernel treats them as silence.
+    Optionally, so are the samples close to a change of the rectified input
+    level, where a gain computed at control rate is still interpolating.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "../../../Source/DSP/CompressorKernel.h"
+
+namespace GoldenReference
+{
+    struct Case
+    {
+        juce::String name;
+        VocalDSP::GainCurve curve;
+        std::vector<double> input, golden;
+    };
+
+    /** Reads a file of little endian float64 samples. */
+    inline bool loadSamples (const juce::File& file, std::vector<double>& samples)
+    {
+        juce::MemoryBlock data;
+
+        if (! file.loadFileAsData (data) || data.getSize() % sizeof (double) != 0)
+            return false;
+
+        samples.resize (data.getSize() / sizeof (double));
+        std::memcpy (samples.data(), data.getData(), data.getSize());
+
+        for (auto& sample : samples)
+            sample = juce::ByteOrder::swapIfBigEndian (sample);
+
+        return true;
+    }
+
+    /** Reads manifest.json and every case it lists. Returns an error message on failure. */
+    inline juce::String load (const juce::File& directory, std::vector<Case>& cases, double& sampleRate)
+    {
+        const auto manifest = juce::JSON::parse (directory.getChildFile ("manifest.json"));
+        const auto* list = manifest["cases"].getArray();
+
+        if ((int) manifest["version"] != 1 || list == nullptr)
+            return "No golden manifest in " + directory.getFullPathName();
+
+        sampleRate = manifest["sampleRate"];
+
+        for (const auto& entry : *list)
+        {
+            Case c;
+            c.name = entry["name"].toString();
+            c.curve.threshold = entry["threshold"];
+            c.curve.ratio = entry["ratio"];
+            c.curve.knee = entry["knee"];
+
+            if (! loadSamples (directory.getChildFile (entry["input"].toString()), c.input)
+                 || ! loadSamples (directory.getChildFile (entry["golden"].toString()), c.golden)
+                 || c.input.size() != c.golden.size())
+                return "Cannot read the samples of " + c.name;
+
+            cases.push_back (std::move (c));
+        }
+
+        return {};
+    }
+
+    //==============================================================================
+    struct Error
+    {
+        double maximumDb = 0.0;
+        double sumSquares = 0.0;
+        juce::int64 count = 0;
+
+        /** Adds the errors of a processed case. With a settling time, samples
+            less than that many samples before or after a change of the
+            rectified input level are left out.
+        */
+        template <typename SampleType>
+        void add (const Case& c, const SampleType* output, int settlingSamples = 0)
+        {
+            const auto numSamples = (int) c.input.size();
+            std::vector<bool> settling ((size_t) numSamples, false);
+
+            if (settlingSamples > 0)
+                for (int i = 1; i < numSamples; ++i)
+                    if (std::abs (c.input[(size_t) i]) != std::abs (c.input[(size_t) i - 1]))
+                        for (int j = std::max (0, i - settlingSamples); j < std::min (numSamples, i + settlingSamples); ++j)
+                            settling[(size_t) j] = true;
+
+            for (size_t i = 0; i < c.input.size(); ++i)
+            {
+                const auto input = std::abs (c.input[i]);
+
+                if (input <= 1.0e-5 || settling[i])
+                    continue;
+
+                const auto error = std::abs (std::log10 (std::abs ((double) output[i]) / std::abs (c.golden[i])) * 20.0);
+
+                // A NaN or a silenced sample is as wrong as it gets
+                const auto clipped = std::isfinite (error) ? error : 1000.0;
+
+                maximumDb = std::max (maximumDb, clipped);
+                sumSquares += clipped * clipped;
+                ++count;
+            }
+        }
+
+        double getRmsDb() const noexcept    { return count > 0 ? std::sqrt (sumSquares / (double) count) : 0.0; }
+    };
+}
@@ -0,0 +1,851 @@
+/*
+  ==============================================================================
+
+    Microbenchmarks for the Vocal Compressor's processing hot path.
+
+    Runs the DSP core that processBlock delegates to over a matrix of block
+    sizes, channel counts, parameter automation and input signals, plus the
+    individual kernel stages, and writes the results as JSON. The
+    multi-stream engine is compared against one kernel per stream, and the
+    multiband engine against one kernel per band.
+
+    With --golden it runs every processing mode against golden files
+    generated from the notebook model by Golden/generate_golden.py, checks
+    each mode's error against its bounds and records its throughput in the
+    same run.
+
+    With --report it instead summarises an instrumentation dump written by
+    the plugin's debug panel, and fails if the audio thread allocated,
+    locked or overran its budget.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+
+#include "../../../Source/DSP/CompressorKernel.h"
+#include "../../../Source/DSP/MultiStreamCompressor.h"
+#include "../../../Source/DSP/MultibandCompressor.h"
+#include "../../../Source/DSP/Oversampler.h"
+#include "../../../Source/Instrumentation.h"
+#include "GoldenReference.h"
+#include "TestSignals.h"
+
+//==============================================================================
+static constexpr double sampleRate = 48000.0;
+
+struct Timing
+{
+    double nsPerSample = 0.0;       // per sample of one channel
+    double realTimeFactor = 0.0;    // audio duration / processing time
+};
+
+/** Returns the median of several timed runs of a function that processes numSamples per channel. */
+template <typename Function>
+static Timing measure (int numSamples, int numChannels, int repetitions, Function&& function)
+{
+    function(); // warm up caches and the curve table
+
+    std::vector<double> seconds;
+
+    for (int i = 0; i < repetitions; ++i)
+    {
+        const auto start = juce::Time::getHighResolutionTicks();
+        function();
+        seconds.push_back (juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - start));
+    }
+
+    std::sort (seconds.begin(), seconds.end());
+    const double median = seconds[seconds.size() / 2];
+
+    Timing timing;
+    timing.nsPerSample = median * 1.0e9 / ((double) numSamples * numChannels);
+    timing.realTimeFactor = ((double) numSamples / sampleRate) / median;
+    return timing;
+}
+
+//==============================================================================
+struct Case
+{
+    int blockSize;
+    int numChannels;
+    bool automation;
+    TestSignals::Type signal;
+    bool doublePrecision = false;
+    VocalDSP::Detector detector = VocalDSP::Detector::peak;
+    float lookahead = 0.0f;
+    int oversampling = 0;       // stages, 2^n times the rate
+    VocalDSP::MakeUp makeUp = VocalDSP::MakeUp::curve;
+};
+
+template <typename SampleType>
+static Timing timeCase (const Case& c, int numSamples, int repetitions)
+{
+    std::vector<std::vector<SampleType>> source, work;
+
+    for (int channel = 0; channel < c.numChannels; ++channel)
+    {
+        const auto signal = TestSignals::generate (c.signal, numSamples, sampleRate, (unsigned int) channel + 1);
+        source.emplace_back (signal.begin(), signal.end());
+    }
+
+    work = source;
+
+    std::vector<SampleType*> pointers (work.size());
+
+    VocalDSP::CompressorKernel<SampleType> kernel;
+    kernel.prepare (sampleRate * (1 << c.oversampling), c.blockSize << c.oversampling, c.numChannels);
+
+    VocalDSP::Oversampler<SampleType> oversampler;
+    oversampler.prepare (c.blockSize, c.numChannels);
+
+    VocalDSP::Parameters parameters;
+    parameters.detector = c.detector;
+    parameters.lookahead = c.lookahead;
+    parameters.makeUp = c.makeUp;
+    int blockIndex = 0;
+
+    return measure (numSamples, c.numChannels, repetitions, [&]
+    {
+        for (size_t channel = 0; channel < work.size(); ++channel)
+            std::copy (source[channel].begin(), source[channel].end(), work[channel].begin());
+
+        kernel.reset();
+        oversampler.reset();
+
+        for (int offset = 0; offset < numSamples; offset += c.blockSize)
+        {
+            const int n = std::min (c.blockSize, numSamples - offset);
+
+            for (size_t channel = 0; channel < work.size(); ++channel)
+                pointers[channel] = work[channel].data() + offset;
+
+            if (c.automation)
+            {
+                // A host automating the curve moves every block
+                parameters.threshold = -18.0f + (float) (blockIndex % 64) * 0.1f;
+                parameters.attack = 5.0f + (float) (blockIndex % 16) * 0.25f;
+                ++blockIndex;
+            }
+
+            oversampler.process (pointers.data(), c.numChannels, n, c.oversampling,
+                                 [&] (SampleType* const* channels, int numChannels, int numOversampled)
+            {
+                kernel.process (channels, numChannels, numOversampled, parameters);
+            });
+        }
+    });
+}
+
+static const char* getDetectorName (VocalDSP::Detector detector)
+{
+    switch (detector)
+    {
+        case VocalDSP::Detector::peak:          return "peak";
+        case VocalDSP::Detector::rms:           return "rms";
+        case VocalDSP::Detector::logarithmic:   return "log";
+    }
+
+    return "";
+}
+
+static juce::var runCase (const Case& c, int numSamples, int repetitions)
+{
+    const auto timing = c.doublePrecision ? timeCase<double> (c, numSamples, repetitions)
+                                          : timeCase<float>  (c, numSamples, repetitions);
+
+    auto* result = new juce::DynamicObject();
+    result->setProperty ("blockSize", c.blockSize);
+    result->setProperty ("channels", c.numChannels);
+    result->setProperty ("automation", c.automation);
+    result->setProperty ("signal", TestSignals::getName (c.signal));
+    result->setProperty ("precision", c.doublePrecision ? "double" : "float");
+    result->setProperty ("detector", getDetectorName (c.detector));
+    result->setProperty ("lookahead", c.lookahead);
+    result->setProperty ("oversampling", 1 << c.oversampling);
+    result->setProperty ("makeUp", c.makeUp == VocalDSP::MakeUp::loudness ? "loudness" : "curve");
+    result->setProperty ("nsPerSample", timing.nsPerSample);
+    result->setProperty ("realTimeFactor", timing.realTimeFactor);
+    return juce::var (result);
+}
+
+//==============================================================================
+static juce::var runStages (int numSamples, int repetitions)
+{
+    const auto input = TestSignals::generate (TestSignals::Type::vocal, numSamples, sampleRate, 1);
+    std::vector<float> envelope ((size_t) numSamples), gain ((size_t) numSamples), samples (input);
+
+    VocalDSP::GainCurveTable<float> curve;
+    curve.update ({ -18.0f, 4.0f, 18.0f });
+
+    VocalDSP::CompressorKernel<float>::detect (input.data(), envelope.data(), numSamples, 0.0f, 0.9f, 0.999f);
+
+    juce::Array<juce::var> stages;
+
+    auto addStage = [&] (const char* name, Timing timing)
+    {
+        auto* stage = new juce::DynamicObject();
+        stage->setProperty ("stage", name);
+        stage->setProperty ("nsPerSample", timing.nsPerSample);
+        stages.add (juce::var (stage));
+    };
+
+    addStage ("detect", measure (numSamples, 1, repetitions, [&]
+    {
+        VocalDSP::CompressorKernel<float>::detect (input.data(), envelope.data(), numSamples, 0.0f, 0.9f, 0.999f);
+    }));
+
+    const std::pair<const char*, VocalDSP::Accuracy> accuracies[] = { { "exact", VocalDSP::Accuracy::exact },
+                                                                        { "high",  VocalDSP::Accuracy::high },
+                                                                        { "fast",  VocalDSP::Accuracy::fast } };
+
+    for (auto& [name, accuracy] : accuracies)
+    {
+        addStage ((juce::String ("gainToDecibels/") + name).toRawUTF8(), measure (numSamples, 1, repetitions, [&]
+        {
+            VocalDSP::Decibels::gainToDecibels (envelope.data(), gain.data(), numSamples, accuracy);
+        }));
+    }
+
+    VocalDSP::Decibels::gainToDecibels (envelope.data(), envelope.data(), numSamples, VocalDSP::Accuracy::exact);
+
+    addStage ("getGainReduction", measure (numSamples, 1, repetitions, [&]
+    {
+        VocalDSP::CompressorKernel<float>::computeGain (envelope.data(), gain.data(), numSamples, curve, 0.0f);
+    }));
+
+    // The closed form an automated block evaluates instead, here with the threshold ramping over the whole run
+    std::vector<float> threshold ((size_t) numSamples), slope ((size_t) numSamples, 0.75f),
+                       knee ((size_t) numSamples, 18.0f), makeUp ((size_t) numSamples, 0.0f);
+
+    for (int i = 0; i < numSamples; ++i)
+        threshold[(size_t) i] = -24.0f + 12.0f * (float) i / (float) numSamples;
+
+    addStage ("getGainReduction/ramped", measure (numSamples, 1, repetitions, [&]
+    {
+        VocalDSP::CompressorKernel<float>::computeGain (envelope.data(), gain.data(), numSamples, threshold.data(),
+                                                        slope.data(), knee.data(), makeUp.data());
+    }));
+
+    for (auto& [name, accuracy] : accuracies)
+    {
+        addStage ((juce::String ("decibelsToGain/") + name).toRawUTF8(), measure (numSamples, 1, repetitions, [&]
+        {
+            VocalDSP::Decibels::decibelsToGain (envelope.data(), gain.data(), numSamples, accuracy);
+        }));
+    }
+
+    addStage ("applyGain", measure (numSamples, 1, repetitions, [&]
+    {
+        VocalDSP::CompressorKernel<float>::applyGain (samples.data(), gain.data(), numSamples);
+    }));
+
+    return stages;
+}
+
+//==============================================================================
+static juce::var runStreams (int numStreams, int numSamples, int repetitions)
+{
+    constexpr int blockSize = 256;
+
+    std::vector<std::vector<float>> source, work;
+
+    for (int stream = 0; stream < numStreams; ++stream)
+        source.push_back (TestSignals::generate (TestSignals::Type::vocal, numSamples, sampleRate, (unsigned int) stream + 1));
+
+    work = source;
+
+    std::vector<float*> pointers (work.size());
+
+    auto copySource = [&]
+    {
+        for (size_t stream = 0; stream < work.size(); ++stream)
+            std::copy (source[stream].begin(), source[stream].end(), work[stream].begin());
+    };
+
+    VocalDSP::MultiStreamCompressor engine;
+    engine.prepare (sampleRate, blockSize, numStreams);
+
+    auto batched = measure (numSamples, numStreams, repetitions, [&]
+    {
+        copySource();
+        engine.reset();
+
+        for (int offset = 0; offset < numSamples; offset += blockSize)
+        {
+            for (size_t stream = 0; stream < work.size(); ++stream)
+                pointers[stream] = work[stream].data() + offset;
+
+            engine.process (pointers.data(), std::min (blockSize, numSamples - offset));
+        }
+    });
+
+    std::vector<VocalDSP::CompressorKernel<float>> kernels ((size_t) numStreams);
+
+    for (auto& kernel : kernels)
+        kernel.prepare (sampleRate, blockSize, 1);
+
+    const VocalDSP::Parameters parameters;
+
+    auto separate = measure (numSamples, numStreams, repetitions, [&]
+    {
+        copySource();
+
+        for (int offset = 0; offset < numSamples; offset += blockSize)
+        {
+            for (size_t stream = 0; stream < work.size(); ++stream)
+            {
+                float* samples = work[stream].data() + offset;
+                kernels[stream].process (&samples, 1, std::min (blockSize, numSamples - offset), parameters);
+            }
+        }
+    });
+
+    auto* result = new juce::DynamicObject();
+    result->setProperty ("streams", numStreams);
+    result->setProperty ("blockSize", blockSize);
+    result->setProperty ("nsPerSample", batched.nsPerSample);
+    result->setProperty ("kernelNsPerSample", separate.nsPerSample);
+    return juce::var (result);
+}
+
+//==============================================================================
+static juce::var runMultiband (int numBands, int numSamples, int repetitions)
+{
+    constexpr int blockSize = 256, numChannels = 2;
+
+    std::vector<std::vector<float>> source, work;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+        source.push_back (TestSignals::generate (TestSignals::Type::vocal, numSamples, sampleRate, (unsigned int) channel + 1));
+
+    work = source;
+
+    std::vector<float*> pointers (work.size());
+
+    auto copySource = [&]
+    {
+        for (size_t channel = 0; channel < work.size(); ++channel)
+            std::copy (source[channel].begin(), source[channel].end(), work[channel].begin());
+    };
+
+    VocalDSP::MultibandCompressor<float> engine;
+    engine.prepare (sampleRate, blockSize, numChannels);
+
+    VocalDSP::Bands bands;
+    bands.numBands = numBands;
+
+    const VocalDSP::Parameters parameters;
+
+    auto multiband = measure (numSamples, numChannels, repetitions, [&]
+    {
+        copySource();
+        engine.reset();
+
+        for (int offset = 0; offset < numSamples; offset += blockSize)
+        {
+            for (size_t channel = 0; channel < work.size(); ++channel)
+                pointers[channel] = work[channel].data() + offset;
+
+            engine.process (pointers.data(), numChannels, std::min (blockSize, numSamples - offset), parameters, bands);
+        }
+    });
+
+    // Chained instances, without even the crossovers they would need
+    std::vector<VocalDSP::CompressorKernel<float>> kernels ((size_t) numBands);
+
+    for (auto& kernel : kernels)
+        kernel.prepare (sampleRate, blockSize, numChannels);
+
+    auto separate = measure (numSamples, numChannels, repetitions, [&]
+    {
+        copySource();
+
+        for (int offset = 0; offset < numSamples; offset += blockSize)
+        {
+            for (size_t channel = 0; channel < work.size(); ++channel)
+                pointers[channel] = work[channel].data() + offset;
+
+            for (auto& kernel : kernels)
+                kernel.process (pointers.data(), numChannels, std::min (blockSize, numSamples - offset), parameters);
+        }
+    });
+
+    auto* result = new juce::DynamicObject();
+    result->setProperty ("bands", numBands);
+    result->setProperty ("channels", numChannels);
+    result->setProperty ("blockSize", blockSize);
+    result->setProperty ("nsPerSample", multiband.nsPerSample);
+    result->setProperty ("kernelNsPerSample", separate.nsPerSample);
+    return juce::var (result);
+}
+
+//==============================================================================
+/** A processing mode checked against the notebook, with the errors it may show. */
+struct GoldenMode
+{
+    const char* name;
+    bool doublePrecision;
+    bool multiStream;
+    VocalDSP::Accuracy accuracy;
+    int controlInterval;
+    VocalDSP::Detector detector;
+    VocalDSP::Link link;
+    int numChannels;
+    double maximumErrorDb, rmsErrorDb;
+    const char* signal = nullptr;   // only the cases of this signal, or all of them
+    bool ballistics = false;        // default attack and release, against a model of control rate
+};
+
+// The notebook has no ballistics or lookahead, and detects the rectified
+// sample, so each mode runs with zero attack and release and the RMS
+// detector, lookahead and oversampling are left out. Control rate cannot
+// follow a waveform the detector tracks sample by sample, so it is checked
+// on the level steps only: their rectified level is constant within a
+// step, and the gain has to match the notebook everywhere but within one
+// control interval of a level change, where it is being interpolated.
+// The interpolation itself is checked with the default attack and release,
+// which the notebook cannot model, against the audio rate stages sampled
+// at the control points and interpolated independently.
+static const GoldenMode goldenModes[] =
+{
+    { "float/exact",        false, false, VocalDSP::Accuracy::exact, 1,  VocalDSP::Detector::peak,        VocalDSP::Link::unlinked, 1, 0.001, 0.0002 },
+    { "float/high",         false, false, VocalDSP::Accuracy::high,  1,  VocalDSP::Detector::peak,        VocalDSP::Link::unlinked, 1, 0.001, 0.0002 },
+    { "float/fast",         false, false, VocalDSP::Accuracy::fast,  1,  VocalDSP::Detector::peak,        VocalDSP::Link::unlinked, 1, 0.01,  0.003 },
+    { "double/exact",       true,  false, VocalDSP::Accuracy::exact, 1,  VocalDSP::Detector::peak,        VocalDSP::Link::unlinked, 1, 0.001, 0.0002 },
+    { "double/high",        true,  false, VocalDSP::Accuracy::high,  1,  VocalDSP::Detector::peak,        VocalDSP::Link::unlinked, 1, 0.001, 0.0002 },
+    { "float/high/log",     false, false, VocalDSP::Accuracy::high,  1,  VocalDSP::Detector::logarithmic, VocalDSP::Link::unlinked, 1, 0.001, 0.0002 },
+    { "float/high/max",     false, false, VocalDSP::Accuracy::high,  1,  VocalDSP::Detector::peak,        VocalDSP::Link::max,      2, 0.001, 0.0002 },
+    { "float/high/rms",     false, false, VocalDSP::Accuracy::high,  1,  VocalDSP::Detector::peak,        VocalDSP::Link::rms,      2, 0.001, 0.0002 },
+    { "float/high/cr8",     false, false, VocalDSP::Accuracy::high,  8,  VocalDSP::Detector::peak,        VocalDSP::Link::unlinked, 1, 0.001, 0.0002, "levelSteps" },
+    { "float/high/cr32",    false, false, VocalDSP::Accuracy::high,  32, VocalDSP::Detector::peak,        VocalDSP::Link::unlinked, 1, 0.001, 0.0002, "levelSteps" },
+    { "float/high/cr8/ballistics",  false, false, VocalDSP::Accuracy::high, 8,  VocalDSP::Detector::peak, VocalDSP::Link::unlinked, 1, 0.001, 0.0002, nullptr, true },
+    { "float/high/cr32/ballistics", false, false, VocalDSP::Accuracy::high, 32, VocalDSP::Detector::peak, VocalDSP::Link::unlinked, 1, 0.001, 0.0002, nullptr, true },
+    { "streams/high",       false, true,  VocalDSP::Accuracy::high,  1,  VocalDSP::Detector::peak,        VocalDSP::Link::unlinked, 1, 0.001, 0.0002 },
+    { "streams/fast",       false, true,  VocalDSP::Accuracy::fast,  1,  VocalDSP::Detector::peak,        VocalDSP::Link::unlinked, 1, 0.01,  0.003 },
+};
+
+/** Runs every golden case through one mode. Returns its errors and throughput. */
+template <typename SampleType>
+static juce::var runGoldenMode (const GoldenMode& mode, const std::vector<GoldenReference::Case>& cases,
+                                double caseSampleRate, int repetitions, bool& passed)
+{
+    constexpr int blockSize = 256;
+
+    // work[case][channel], every channel a copy of the case's input
+    std::vector<std::vector<std::vector<SampleType>>> work (cases.size());
+    size_t totalSamples = 0;
+
+    for (size_t i = 0; i < cases.size(); ++i)
+    {
+        work[i].assign ((size_t) mode.numChannels, std::vector<SampleType> (cases[i].input.size()));
+        totalSamples += cases[i].input.size();
+    }
+
+    VocalDSP::CompressorKernel<SampleType> kernel;
+    kernel.prepare (caseSampleRate, blockSize, mode.numChannels);
+
+    VocalDSP::MultiStreamCompressor streams;
+
+    if (mode.multiStream)
+    {
+        streams.prepare (caseSampleRate, blockSize, 1);
+        streams.setAccuracy (mode.accuracy);
+    }
+
+    auto parametersFor = [&mode] (const GoldenReference::Case& c)
+    {
+        VocalDSP::Parameters parameters;
+        parameters.threshold = c.curve.threshold;
+        parameters.ratio = c.curve.ratio;
+        parameters.knee = c.curve.knee;
+        parameters.autoGain = 0.0f;
+
+        if (! mode.ballistics)
+        {
+            parameters.attack = 0.0f;
+            parameters.release = 0.0f;
+        }
+
+        parameters.accuracy = mode.accuracy;
+        parameters.controlInterval = mode.controlInterval;
+        parameters.link = mode.link;
+        parameters.detector = mode.detector;
+        return parameters;
+    };
+
+    // With ballistics the reference is a model of control rate built from the
+    // audio rate stages: the gain at the end of every control interval,
+    // interpolated linearly from the one before. The block size is a multiple
+    // of every interval, so the control points fall on one grid.
+    std::vector<GoldenReference::Case> references;
+
+    if (mode.ballistics)
+    {
+        const auto coefficient = [caseSampleRate] (float timeMs)
+        {
+            return (SampleType) std::exp (-2.0 * 3.141592653589793 * 1000.0 / caseSampleRate / timeMs);
+        };
+
+        VocalDSP::GainCurveTable<SampleType> curve;
+
+        for (const auto& c : cases)
+        {
+            const auto parameters = parametersFor (c);
+            const int numSamples = (int) c.input.size();
+            const int interval = mode.controlInterval;
+
+            std::vector<SampleType> input (c.input.begin(), c.input.end()), gain ((size_t) numSamples);
+            curve.update (c.curve);
+
+            VocalDSP::CompressorKernel<SampleType>::detect (input.data(), gain.data(), numSamples, 0,
+                                                            coefficient (parameters.attack), coefficient (parameters.release));
+            VocalDSP::Decibels::gainToDecibels (gain.data(), gain.data(), numSamples, mode.accuracy);
+            VocalDSP::CompressorKernel<SampleType>::computeGain (gain.data(), gain.data(), numSamples, curve, 0);
+            VocalDSP::Decibels::decibelsToGain (gain.data(), gain.data(), numSamples, mode.accuracy);
+
+            auto reference = c;
+
+            for (int start = 0; start < numSamples; start += interval)
+            {
+                const int length = std::min (interval, numSamples - start);
+                const double to = gain[(size_t) (start + length - 1)];
+                const double from = start > 0 ? (double) gain[(size_t) start - 1] : to;
+
+                for (int i = 0; i < length; ++i)
+                    reference.golden[(size_t) (start + i)] = c.input[(size_t) (start + i)] * (from + (to - from) * (i + 1) / length);
+            }
+
+            references.push_back (std::move (reference));
+        }
+    }
+
+    const auto& expected = mode.ballistics ? references : cases;
+
+    const auto timing = measure ((int) totalSamples, mode.numChannels, repetitions, [&]
+    {
+        for (size_t i = 0; i < cases.size(); ++i)
+        {
+            const auto& c = cases[i];
+            const auto parameters = parametersFor (c);
+            const int numSamples = (int) c.input.size();
+
+            for (auto& channel : work[i])
+                std::transform (c.input.begin(), c.input.end(), channel.begin(),
+                                [] (double sample) { return (SampleType) sample; });
+
+            kernel.reset();
+
+            if (mode.multiStream)
+            {
+                streams.reset();
+                streams.setParameters (parameters);
+            }
+
+            std::vector<SampleType*> pointers ((size_t) mode.numChannels);
+
+            for (int offset = 0; offset < numSamples; offset += blockSize)
+            {
+                for (size_t channel = 0; channel < pointers.size(); ++channel)
+                    pointers[channel] = work[i][channel].data() + offset;
+
+                const int n = std::min (blockSize, numSamples - offset);
+
+                if constexpr (std::is_same_v<SampleType, float>)
+                {
+                    if (mode.multiStream)
+                    {
+                        streams.process (pointers.data(), n);
+                        continue;
+                    }
+                }
+
+                kernel.process (pointers.data(), mode.numChannels, n, parameters);
+            }
+        }
+    });
+
+    GoldenReference::Error error;
+
+    for (size_t i = 0; i < cases.size(); ++i)
+    {
+        if (mode.signal != nullptr && ! cases[i].name.startsWith (juce::String (mode.signal) + "_"))
+            continue;
+
+        const int settlingSamples = mode.controlInterval > 1 && ! mode.ballistics ? mode.controlInterval : 0;
+
+        for (auto& channel : work[i])
+            error.add (expected[i], channel.data(), settlingSamples);
+    }
+
+    const bool modePassed = error.maximumDb <= mode.maximumErrorDb && error.getRmsDb() <= mode.rmsErrorDb;
+    passed = passed && modePassed;
+
+    auto* result = new juce::DynamicObject();
+    result->setProperty ("mode", mode.name);
+    result->setProperty ("maximumErrorDb", error.maximumDb);
+    result->setProperty ("rmsErrorDb", error.getRmsDb());
+    result->setProperty ("maximumErrorBoundDb", mode.maximumErrorDb);
+    result->setProperty ("rmsErrorBoundDb", mode.rmsErrorDb);
+    result->setProperty ("passed", modePassed);
+    result->setProperty ("nsPerSample", timing.nsPerSample);
+    result->setProperty ("realTimeFactor", timing.realTimeFactor);
+    return juce::var (result);
+}
+
+/** Checks every mode against the golden files in the directory. Returns 2 if any exceeds its bounds. */
+static int runGolden (const juce::File& directory, int repetitions, juce::var& root)
+{
+    std::vector<GoldenReference::Case> cases;
+    double caseSampleRate = 0.0;
+
+    const auto error = GoldenReference::load (directory, cases, caseSampleRate);
+
+    if (error.isNotEmpty())
+    {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+
+    juce::Array<juce::var> results;
+    bool passed = true;
+
+    for (const auto& mode : goldenModes)
+    {
+        auto result = mode.doublePrecision ? runGoldenMode<double> (mode, cases, caseSampleRate, repetitions, passed)
+                                           : runGoldenMode<float>  (mode, cases, caseSampleRate, repetitions, passed);
+
+        std::cerr << mode.name << ": max " << juce::String ((double) result["maximumErrorDb"], 5) << " dB, rms "
+                  << juce::String ((double) result["rmsErrorDb"], 5) << " dB, "
+                  << juce::String ((double) result["nsPerSample"], 2) << " ns/sample"
+                  << ((bool) result["passed"] ? "" : "  FAILED") << std::endl;
+        results.add (result);
+    }
+
+    auto* object = new juce::DynamicObject();
+    object->setProperty ("version", 1);
+    object->setProperty ("timestamp", juce::Time::getCurrentTime().toISO8601 (true));
+    object->setProperty ("cpu", juce::SystemStats::getCpuModel());
+    object->setProperty ("simd", VocalDSP::getSIMDInstructionSet());
+    object->setProperty ("cases", (int) cases.size());
+    object->setProperty ("passed", passed);
+    object->setProperty ("golden", results);
+    root = juce::var (object);
+
+    return passed ? 0 : 2;
+}
+
+//==============================================================================
+/** Prints an instrumentation dump. Returns 2 if it shows real-time violations. */
+static int reportInstrumentation (const juce::File& file)
+{
+    Instrumentation::Snapshot snapshot;
+
+    if (! Instrumentation::Snapshot::fromVar (juce::JSON::parse (file), snapshot))
+    {
+        std::cerr << "Cannot read an instrumentation dump from " << file.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    const auto mean = snapshot.numBlocks > 0 ? snapshot.totalMicroseconds / (double) snapshot.numBlocks : 0.0;
+
+    std::cout << "Sample rate    " << snapshot.sampleRate << " Hz\n"
+              << "Blocks         " << snapshot.numBlocks << "\n"
+              << "Overruns       " << snapshot.numOverruns << "\n"
+              << "Mean           " << juce::String (mean, 1) << " us\n"
+              << "p50            " << juce::String (snapshot.getPercentile (0.5), 1) << " us\n"
+              << "p99            " << juce::String (snapshot.getPercentile (0.99), 1) << " us\n"
+              << "p99.9          " << juce::String (snapshot.getPercentile (0.999), 1) << " us\n"
+              << "Maximum        " << juce::String (snapshot.maximumMicroseconds, 1) << " us\n"
+              << "Maximum load   " << juce::String (100.0 * snapshot.maximumLoad, 1) << " %\n"
+              << "Allocations    " << snapshot.numAllocations << "\n"
+              << "Deallocations  " << snapshot.numDeallocations << "\n"
+              << "Locks          " << snapshot.numLocks << std::endl;
+
+    const bool clean = snapshot.numOverruns == 0 && snapshot.numAllocations == 0
+                        && snapshot.numDeallocations == 0 && snapshot.numLocks == 0;
+
+    return clean ? 0 : 2;
+}
+
+//==============================================================================
+/** Writes the results to --output, or to stdout. */
+static bool writeResults (const juce::ArgumentList& args, const juce::var& results)
+{
+    const auto json = juce::JSON::toString (results);
+
+    if (args.containsOption ("--output"))
+    {
+        const auto file = args.getFileForOption ("--output");
+
+        if (! file.replaceWithText (json))
+        {
+            std::cerr << "Cannot write " << file.getFullPathName() << std::endl;
+            return false;
+        }
+    }
+    else
+    {
+        std::cout << json << std::endl;
+    }
+
+    return true;
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ArgumentList args (argc, argv);
+
+    if (args.containsOption ("--help|-h"))
+    {
+        std::cout << "Usage: VocalCompressorBenchmark [--output=<file.json>] [--quick] [--ftz]\n"
+                     "       VocalCompressorBenchmark --golden=<directory> [--output=<file.json>] [--quick] [--ftz]\n"
+                     "       VocalCompressorBenchmark --report=<dump.json>\n"
+                     "\n"
+                     "  --output   write the JSON results to a file instead of stdout\n"
+                     "  --quick    fewer block sizes and shorter runs\n"
+                     "  --ftz      flush denormals to zero, as processBlock does in a host\n"
+                     "  --golden   check every processing mode against the notebook model's output,\n"
+                     "             written by Golden/generate_golden.py; exits with 2 if a mode\n"
+                     "             exceeds its error bounds\n"
+                     "  --report   summarise a dump from the plugin's instrumentation panel; exits\n"
+                     "             with 2 if it shows overruns, allocations or locks\n";
+        return 0;
+    }
+
+    if (args.containsOption ("--report"))
+        return reportInstrumentation (args.getFileForOption ("--report"));
+
+    const bool quick = args.containsOption ("--quick");
+    const bool flushDenormals = args.containsOption ("--ftz");
+
+    const int numSamples = (int) sampleRate * (quick ? 2 : 10);
+    const int repetitions = quick ? 3 : 7;
+
+    std::unique_ptr<juce::ScopedNoDenormals> noDenormals;
+
+    if (flushDenormals)
+        noDenormals = std::make_unique<juce::ScopedNoDenormals>();
+
+    if (args.containsOption ("--golden"))
+    {
+        juce::var results;
+        const int result = runGolden (args.getFileForOption ("--golden"), repetitions, results);
+
+        if (result == 1 || ! writeResults (args, results))
+            return 1;
+
+        return result;
+    }
+
+    juce::Array<int> blockSizes;
+
+    for (int blockSize = 16; blockSize <= 4096; blockSize *= quick ? 4 : 2)
+        blockSizes.add (blockSize);
+
+    const TestSignals::Type signals[] = { TestSignals::Type::silent, TestSignals::Type::sine,
+                                          TestSignals::Type::vocal, TestSignals::Type::denormalTail };
+
+    juce::Array<juce::var> results;
+
+    for (auto signal : signals)
+        for (int numChannels : { 1, 2, 6 })
+            for (bool automation : { false, true })
+                for (int blockSize : blockSizes)
+                {
+                    auto result = runCase ({ blockSize, numChannels, automation, signal }, numSamples, repetitions);
+                    std::cerr << TestSignals::getName (signal) << ", " << numChannels << " ch, "
+                              << (automation ? "automated" : "static") << ", block " << blockSize << ": "
+                              << juce::String ((double) result["nsPerSample"], 2) << " ns/sample" << std::endl;
+                    results.add (result);
+                }
+
+    // The double precision engine, as a 64 bit host would run it
+    for (int blockSize : blockSizes)
+    {
+        auto result = runCase ({ blockSize, 2, false, TestSignals::Type::vocal, true }, numSamples, repetitions);
+        std::cerr << "vocal, 2 ch, static, double, block " << blockSize << ": "
+                  << juce::String ((double) result["nsPerSample"], 2) << " ns/sample" << std::endl;
+        results.add (result);
+    }
+
+    // The other detectors, against the peak detector in the matrix above
+    for (auto detector : { VocalDSP::Detector::rms, VocalDSP::Detector::logarithmic })
+        for (int blockSize : blockSizes)
+        {
+            auto result = runCase ({ blockSize, 2, false, TestSignals::Type::vocal, false, detector }, numSamples, repetitions);
+            std::cerr << "vocal, 2 ch, static, " << getDetectorName (detector) << " detector, block " << blockSize << ": "
+                      << juce::String ((double) result["nsPerSample"], 2) << " ns/sample" << std::endl;
+            results.add (result);
+        }
+
+    // The lookahead's delay line and sliding maximum
+    for (int blockSize : blockSizes)
+    {
+        auto result = runCase ({ blockSize, 2, false, TestSignals::Type::vocal, false,
+                                 VocalDSP::Detector::peak, 5.0f }, numSamples, repetitions);
+        std::cerr << "vocal, 2 ch, static, 5 ms lookahead, block " << blockSize << ": "
+                  << juce::String ((double) result["nsPerSample"], 2) << " ns/sample" << std::endl;
+        results.add (result);
+    }
+
+    // Oversampling, per sample at the base rate including the filters
+    for (int stages = 1; stages <= VocalDSP::Oversampler<float>::maximumStages; ++stages)
+        for (int blockSize : blockSizes)
+        {
+            auto result = runCase ({ blockSize, 2, false, TestSignals::Type::vocal, false,
+                                     VocalDSP::Detector::peak, 0.0f, stages }, numSamples, repetitions);
+            std::cerr << "vocal, 2 ch, static, " << (1 << stages) << "x oversampling, block " << blockSize << ": "
+                      << juce::String ((double) result["nsPerSample"], 2) << " ns/sample" << std::endl;
+            results.add (result);
+        }
+
+    // The two loudness meters of the program-dependent make-up gain
+    for (int blockSize : blockSizes)
+    {
+        auto result = runCase ({ blockSize, 2, false, TestSignals::Type::vocal, false,
+                                 VocalDSP::Detector::peak, 0.0f, 0, VocalDSP::MakeUp::loudness }, numSamples, repetitions);
+        std::cerr << "vocal, 2 ch, static, loudness make-up, block " << blockSize << ": "
+                  << juce::String ((double) result["nsPerSample"], 2) << " ns/sample" << std::endl;
+        results.add (result);
+    }
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty ("version", 1);
+    root->setProperty ("timestamp", juce::Time::getCurrentTime().toISO8601 (true));
+    root->setProperty ("cpu", juce::SystemStats::getCpuModel());
+    root->setProperty ("simd", VocalDSP::getSIMDInstructionSet());
+    root->setProperty ("sampleRate", sampleRate);
+    root->setProperty ("flushDenormals", flushDenormals);
+    root->setProperty ("results", results);
+    root->setProperty ("stages", runStages (numSamples, repetitions));
+
+    juce::Array<juce::var> streams;
+
+    for (int numStreams : { 1, 8, 64, 256 })
+    {
+        // One second per stream, so the largest case still fits in memory comfortably
+        auto result = runStreams (numStreams, (int) sampleRate, repetitions);
+        std::cerr << numStreams << " streams: " << juce::String ((double) result["nsPerSample"], 2) << " ns/sample, "
+                  << juce::String ((double) result["kernelNsPerSample"], 2) << " with one kernel each" << std::endl;
+        streams.add (result);
+    }
+
+    root->setProperty ("streams", streams);
+
+    juce::Array<juce::var> multiband;
+
+    for (int numBands = 2; numBands <= VocalDSP::Bands::maximumBands; ++numBands)
+    {
+        auto result = runMultiband (numBands, numSamples, repetitions);
+        std::cerr << numBands << " bands: " << juce::String ((double) result["nsPerSample"], 2) << " ns/sample, "
+                  << juce::String ((double) result["kernelNsPerSample"], 2) << " with one kernel each" << std::endl;
+        multiband.add (result);
+    }
+
+    root->setProperty ("multiband", multiband);
+
+    return writeResults (args, juce::var (root)) ? 0 : 1;
+}
@@ -0,0 +1,115 @@
+/*
+  ==============================================================================
+
+    TestSignals.h
+
+    Deterministic input signals for the benchmark.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace TestSignals
+{
+    enum class Type
+    {
+        silent,
+        sine,
+        vocal,
+        denormalTail
+    };
+
+    inline const char* getName (Type type)
+    {
+        switch (type)
+        {
+            case Type::silent:          return "silent";
+            case Type::sine:            return "sine";
+            case Type::vocal:           return "vocal";
+            case Type::denormalTail:    return "denormalTail";
+        }
+
+        return "";
+    }
+
+    /** Generates numSamples of one channel. Channels differ by seed only. */
+    inline std::vector<float> generate (Type type, int numSamples, double sampleRate, unsigned int seed)
+    {
+        constexpr double twoPi = 6.283185307179586;
+
+        std::vector<float> signal ((size_t) numSamples, 0.0f);
+        std::mt19937 random (seed);
+        std::normal_distribution<float> noise (0.0f, 1.0f);
+
+        switch (type)
+        {
+            case Type::silent:
+                break;
+
+            case Type::sine:
+                // 220 Hz at -6 dBFS
+                for (int i = 0; i < numSamples; ++i)
+                    signal[(size_t) i] = 0.5f * (float) std::sin (twoPi * 220.0 * i / sampleRate);
+                break;
+
+            case Type::vocal:
+            {
+                // Harmonic voice with a drifting pitch, breath noise, syllables at
+                // about 4 Hz, pauses every other second and a plosive every 0.5 s
+                float breath = 0.0f;
+                double phase = 0.0;
+
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    const double t = i / sampleRate;
+                    const double pitch = 140.0 + 30.0 * std::sin (t * 3.0);
+                    phase += twoPi * pitch / sampleRate;
+
+                    float voice = 0.0f;
+
+                    for (int harmonic = 1; harmonic < 8; ++harmonic)
+                        voice += (float) std::sin (phase * harmonic) / (float) harmonic;
+
+                    breath = 0.9f * breath + 0.1f * noise (random);
+
+                    float syllable = (float) std::max (0.0, std::sin (twoPi * 4.0 * t));
+                    syllable *= syllable;
+
+                    if (std::fmod (t, 2.0) > 1.6)
+                        syllable = 0.0f;
+
+                    const int plosivePosition = i % (int) (sampleRate / 2);
+                    const float plosive = plosivePosition < 200 ? noise (random) * (1.0f - (float) plosivePosition / 200.0f)
+                                                                : 0.0f;
+
+                    signal[(size_t) i] = 0.3f * syllable * (0.5f * voice + breath) + 0.5f * plosive;
+                }
+                break;
+            }
+
+            case Type::denormalTail:
+            {
+                // Short bursts followed by exponential tails that decay into the
+                // denormal range within half a second and then stay there, where
+                // un-flushed arithmetic gets slow
+                const int period = (int) sampleRate;
+                const double decay = std::exp (std::log (1.0e-40 / 0.5) / (period / 2 - 2400));
+
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    const int position = i % period;
+                    const double amplitude = position < 2400 ? 0.5 : std::max (1.0e-40, 0.5 * std::pow (decay, position - 2400));
+                    signal[(size_t) i] = (float) (amplitude * std::sin (twoPi * 440.0 * i / sampleRate));
+                }
+                break;
+            }
+        }
+
+        return signal;
+    }
+}
@@ -0,0 +1,477 @@
+/*
+  ==============================================================================
+
+    Load test client for the Vocal Compressor stream server.
+
+    Opens many streams to the server at once and feeds each the benchmark's
+    vocal test signal, either paced in real time like a live voice, with
+    the streams' packets spread evenly over the packet period, or as fast
+    as the server takes it.
+
+    Every packet is timed from its last byte going out to the last byte of
+    its compressed output coming back, so the latencies include the wait for
+    a whole server block when packets are smaller than that.
+
+    Linux only, like the server.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "../../StreamServer/Source/StreamProtocol.h"
+#include "../../Benchmark/Source/TestSignals.h"
+
+//==============================================================================
+static void printUsage()
+{
+    std::cout << "Usage: VocalCompressorStreamLoadTest [options]\n"
+                 "\n"
+                 "  --socket=<path>          default " << StreamProtocol::defaultSocketPath << "\n"
+                 "  --streams=<n>            default 100\n"
+                 "  --seconds=<s>            length of the test, default 10\n"
+                 "  --threads=<n>            client threads, default 2\n"
+                 "  --sample-rate=<Hz>       must match the server, default 48000\n"
+                 "  --packet=<n>             samples per packet, default: the server's block size\n"
+                 "  --format=<format>        float or int16, default float\n"
+                 "  --flood                  send as fast as the server takes it instead of in real time\n"
+                 "  --window=<n>             packets in flight per stream when flooding, default 4\n"
+                 "  --threshold=<dBFS>       default -18\n"
+                 "  --ratio=<n>              default 4\n"
+                 "  --list-streams           print every stream's latency\n";
+}
+
+static double getMilliseconds()
+{
+    return juce::Time::getMillisecondCounterHiRes();
+}
+
+//==============================================================================
+struct Options
+{
+    juce::String socketPath = StreamProtocol::defaultSocketPath;
+    int numStreams = 100;
+    double seconds = 10.0;
+    int numThreads = 2;
+    int packetSize = 0;
+    bool flood = false;
+    int window = 4;
+    bool listStreams = false;
+    StreamProtocol::Hello hello;
+};
+
+struct Packet
+{
+    double sentMs = 0.0;
+    juce::int64 endByte = 0;        // of the stream's output, once this packet is back
+};
+
+struct Connection
+{
+    int index = 0;
+    int fd = -1;
+    int bytesPerSample = 4;
+    int signalPosition = 0;
+
+    // Bytes of the current packet still to go, and when the next is due
+    std::vector<char> pending;
+    size_t pendingOffset = 0;
+    double nextDueMs = 0.0;
+
+    juce::int64 sentBytes = 0, receivedBytes = 0;
+    std::deque<Packet> inFlight;
+
+    std::vector<double> latencies;
+    int numLate = 0;
+    bool failed = false;
+};
+
+//==============================================================================
+/** Connects and waits for the server's answer, blocking, before the test starts. */
+static bool connectStream (Connection& connection, const Options& options, StreamProtocol::Accept& accept)
+{
+    sockaddr_un address {};
+    address.sun_family = AF_UNIX;
+    std::strncpy (address.sun_path, options.socketPath.toRawUTF8(), sizeof (address.sun_path) - 1);
+
+    connection.fd = ::socket (AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+    if (connection.fd < 0)
+    {
+        if (errno == EMFILE)
+            std::cerr << "Out of file descriptors, raise the limit with ulimit -n" << std::endl;
+
+        return false;
+    }
+
+    if (::connect (connection.fd, (const sockaddr*) &address, sizeof (address)) != 0
+         || ::send (connection.fd, &options.hello, sizeof (options.hello), MSG_NOSIGNAL) != (ssize_t) sizeof (options.hello)
+         || ::recv (connection.fd, &accept, sizeof (accept), MSG_WAITALL) != (ssize_t) sizeof (accept)
+         || accept.magic != StreamProtocol::acceptMagic
+         || accept.status != (std::uint32_t) StreamProtocol::Status::accepted)
+    {
+        ::close (connection.fd);
+        connection.fd = -1;
+        return false;
+    }
+
+    connection.bytesPerSample = StreamProtocol::getBytesPerSample ((StreamProtocol::Format) options.hello.format);
+    return true;
+}
+
+static void fillPacket (Connection& connection, const std::vector<float>& signal, int packetSize)
+{
+    connection.pending.resize ((size_t) (packetSize * connection.bytesPerSample));
+    connection.pendingOffset = 0;
+
+    for (int i = 0; i < packetSize; ++i)
+    {
+        const float sample = signal[(size_t) connection.signalPosition];
+        connection.signalPosition = (connection.signalPosition + 1) % (int) signal.size();
+
+        if (connection.bytesPerSample == 2)
+        {
+            const auto value = (std::int16_t) juce::jlimit (-32768.0f, 32767.0f, std::round (sample * 32768.0f));
+            std::memcpy (connection.pending.data() + 2 * i, &value, 2);
+        }
+        else
+        {
+            std::memcpy (connection.pending.data() + 4 * i, &sample, 4);
+        }
+    }
+}
+
+/** Sends what the socket takes of the current packet, and returns true once all of it went. */
+static bool sendPending (Connection& connection)
+{
+    while (connection.pendingOffset < connection.pending.size())
+    {
+        const auto result = ::send (connection.fd, connection.pending.data() + connection.pendingOffset,
+                                    connection.pending.size() - connection.pendingOffset, MSG_DONTWAIT | MSG_NOSIGNAL);
+
+        if (result > 0)
+        {
+            connection.pendingOffset += (size_t) result;
+        }
+        else if (result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+        {
+            return false;
+        }
+        else
+        {
+            connection.failed = true;
+            return false;
+        }
+    }
+
+    connection.sentBytes += (juce::int64) connection.pending.size();
+    connection.inFlight.push_back ({ getMilliseconds(), connection.sentBytes });
+    connection.pending.clear();
+    connection.pendingOffset = 0;
+    return true;
+}
+
+static void receive (Connection& connection, double packetMs)
+{
+    char buffer[65536];
+
+    for (;;)
+    {
+        const auto result = ::recv (connection.fd, buffer, sizeof (buffer), MSG_DONTWAIT);
+
+        if (result > 0)
+        {
+            connection.receivedBytes += result;
+            continue;
+        }
+
+        if (result == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+            connection.failed = true;
+
+        if (result == 0 || errno != EINTR)
+            break;
+    }
+
+    const double now = getMilliseconds();
+
+    while (! connection.inFlight.empty() && connection.inFlight.front().endByte <= connection.receivedBytes)
+    {
+        const double latency = now - connection.inFlight.front().sentMs;
+        connection.latencies.push_back (latency);
+
+        if (latency > packetMs)
+            ++connection.numLate;
+
+        connection.inFlight.pop_front();
+    }
+}
+
+//==============================================================================
+/** Starts as many packets as the window allows, when flooding. Returns false if one is left part sent. */
+static bool topUp (Connection& connection, const Options& options, const std::vector<float>& signal)
+{
+    while ((int) connection.inFlight.size() < options.window && ! connection.failed)
+    {
+        fillPacket (connection, signal, options.packetSize);
+
+        if (! sendPending (connection))
+            return connection.failed;
+    }
+
+    return true;
+}
+
+/** Runs a share of the connections for the length of the test. */
+static void runConnections (std::vector<Connection*> connections, const Options& options,
+                            const std::vector<float>& signal, double startMs)
+{
+    const double packetMs = 1000.0 * options.packetSize / options.hello.sampleRate;
+    const double endMs = startMs + options.seconds * 1000.0;
+
+    const int epoll = ::epoll_create1 (EPOLL_CLOEXEC);
+
+    for (auto* connection : connections)
+    {
+        epoll_event event {};
+        event.events = EPOLLIN;
+        event.data.ptr = connection;
+        ::epoll_ctl (epoll, EPOLL_CTL_ADD, connection->fd, &event);
+    }
+
+    std::vector<epoll_event> events (256);
+
+    // Those with a packet the socket did not take in one go
+    std::vector<Connection*> blocked;
+
+    if (options.flood)
+        for (auto* connection : connections)
+            if (! topUp (*connection, options, signal))
+                blocked.push_back (connection);
+
+    // Paced, the connections fall due in turn: they share one period and start in order
+    size_t next = 0;
+
+    for (;;)
+    {
+        const double now = getMilliseconds();
+
+        if (now >= endMs)
+            break;
+
+        blocked.erase (std::remove_if (blocked.begin(), blocked.end(), [] (Connection* connection)
+        {
+            return connection->failed || sendPending (*connection);
+        }), blocked.end());
+
+        // At most one round per pass, so a client falling behind still reads
+        for (size_t n = 0; ! options.flood && n < connections.size() && connections[next]->nextDueMs <= now; ++n)
+        {
+            auto& connection = *connections[next];
+
+            // One still stuck behind its last packet skips a period
+            if (! connection.failed && connection.pending.empty())
+            {
+                fillPacket (connection, signal, options.packetSize);
+
+                if (! sendPending (connection) && ! connection.failed)
+                    blocked.push_back (&connection);
+            }
+
+            connection.nextDueMs += packetMs;
+            next = (next + 1) % connections.size();
+        }
+
+        const double waitMs = options.flood ? 10.0 : connections[next]->nextDueMs - getMilliseconds();
+        const int timeout = blocked.empty() ? juce::jmax (0, (int) std::ceil (waitMs)) : 1;
+        const int numEvents = ::epoll_wait (epoll, events.data(), (int) events.size(), timeout);
+
+        for (int i = 0; i < numEvents; ++i)
+        {
+            auto& connection = *static_cast<Connection*> (events[(size_t) i].data.ptr);
+            receive (connection, packetMs);
+
+            if (options.flood && connection.pending.empty() && ! topUp (connection, options, signal))
+                blocked.push_back (&connection);
+        }
+    }
+
+    ::close (epoll);
+}
+
+//==============================================================================
+static double getPercentile (const std::vector<double>& sorted, double percentile)
+{
+    if (sorted.empty())
+        return 0.0;
+
+    return sorted[(size_t) juce::jlimit (0, (int) sorted.size() - 1, (int) (percentile / 100.0 * (double) sorted.size()))];
+}
+
+int main (int argc, char* argv[])
+{
+    juce::ArgumentList args (argc, argv);
+
+    if (args.containsOption ("--help|-h"))
+    {
+        printUsage();
+        return 0;
+    }
+
+    Options options;
+
+    if (args.containsOption ("--socket"))
+        options.socketPath = args.getValueForOption ("--socket");
+
+    if (args.containsOption ("--streams"))
+        options.numStreams = juce::jmax (1, args.getValueForOption ("--streams").getIntValue());
+
+    if (args.containsOption ("--seconds"))
+        options.seconds = juce::jmax (0.1, args.getValueForOption ("--seconds").getDoubleValue());
+
+    if (args.containsOption ("--threads"))
+        options.numThreads = juce::jmax (1, args.getValueForOption ("--threads").getIntValue());
+
+    if (args.containsOption ("--sample-rate"))
+        options.hello.sampleRate = (std::uint32_t) juce::jmax (1, args.getValueForOption ("--sample-rate").getIntValue());
+
+    if (args.containsOption ("--packet"))
+        options.packetSize = juce::jmax (1, args.getValueForOption ("--packet").getIntValue());
+
+    if (args.containsOption ("--format"))
+        options.hello.format = (std::uint16_t) (args.getValueForOption ("--format") == "int16" ? StreamProtocol::Format::int16
+                                                                                              : StreamProtocol::Format::float32);
+
+    if (args.containsOption ("--window"))
+        options.window = juce::jmax (1, args.getValueForOption ("--window").getIntValue());
+
+    if (args.containsOption ("--threshold"))
+        options.hello.threshold = args.getValueForOption ("--threshold").getFloatValue();
+
+    if (args.containsOption ("--ratio"))
+        options.hello.ratio = args.getValueForOption ("--ratio").getFloatValue();
+
+    options.flood = args.containsOption ("--flood");
+    options.listStreams = args.containsOption ("--list-streams");
+
+    //==============================================================================
+    std::vector<Connection> connections ((size_t) options.numStreams);
+    StreamProtocol::Accept accept;
+    int numConnected = 0;
+
+    for (auto& connection : connections)
+    {
+        connection.index = (int) (&connection - connections.data());
+
+        if (connectStream (connection, options, accept))
+            ++numConnected;
+        else
+            connection.failed = true;
+    }
+
+    if (numConnected == 0)
+    {
+        std::cerr << "No stream was accepted by " << options.socketPath;
+
+        if (accept.magic == StreamProtocol::acceptMagic && accept.status != 0)
+            std::cerr << " (status " << accept.status << ", the server runs at " << accept.sampleRate << " Hz)";
+
+        std::cerr << std::endl;
+        return 1;
+    }
+
+    if (options.packetSize == 0)
+        options.packetSize = (int) accept.blockSize;
+
+    // Two seconds of voice, each stream starting somewhere else in it
+    const auto signal = TestSignals::generate (TestSignals::Type::vocal, 2 * (int) options.hello.sampleRate,
+                                               options.hello.sampleRate, 1);
+
+    const double packetMs = 1000.0 * options.packetSize / options.hello.sampleRate;
+    const double startMs = getMilliseconds() + 100.0;
+
+    for (auto& connection : connections)
+    {
+        connection.signalPosition = (int) ((juce::int64) connection.index * 7919 % (juce::int64) signal.size());
+        connection.nextDueMs = startMs + packetMs * connection.index / options.numStreams;
+    }
+
+    std::cout << numConnected << " of " << options.numStreams << " streams connected, "
+              << (options.flood ? "flooding" : "real time") << ", packets of " << options.packetSize
+              << " samples, server blocks of " << accept.blockSize << std::endl;
+
+    std::vector<std::vector<Connection*>> shares ((size_t) options.numThreads);
+
+    for (auto& connection : connections)
+        if (! connection.failed)
+            shares[(size_t) (connection.index % options.numThreads)].push_back (&connection);
+
+    std::vector<std::thread> threads;
+
+    for (auto& share : shares)
+        threads.emplace_back (runConnections, share, std::cref (options), std::cref (signal), startMs);
+
+    for (auto& thread : threads)
+        thread.join();
+
+    const double elapsedSeconds = (getMilliseconds() - startMs) / 1000.0;
+
+    //==============================================================================
+    std::vector<double> latencies;
+    juce::int64 receivedSamples = 0;
+    int numLate = 0, numFailed = 0;
+
+    for (auto& connection : connections)
+    {
+        latencies.insert (latencies.end(), connection.latencies.begin(), connection.latencies.end());
+        receivedSamples += connection.receivedBytes / connection.bytesPerSample;
+        numLate += connection.numLate;
+        numFailed += connection.failed ? 1 : 0;
+
+        if (connection.fd >= 0)
+            ::close (connection.fd);
+
+        if (options.listStreams && ! connection.latencies.empty())
+        {
+            const auto sum = std::accumulate (connection.latencies.begin(), connection.latencies.end(), 0.0);
+            std::cout << "  stream " << connection.index << ": " << connection.latencies.size() << " packets, latency mean "
+                      << juce::String (sum / (double) connection.latencies.size(), 3) << " ms, max "
+                      << juce::String (*std::max_element (connection.latencies.begin(), connection.latencies.end()), 3)
+                      << " ms, " << connection.numLate << " late" << std::endl;
+        }
+    }
+
+    std::sort (latencies.begin(), latencies.end());
+
+    const auto samplesPerSecond = (double) receivedSamples / elapsedSeconds;
+
+    std::cout << latencies.size() << " packets back, " << juce::String (samplesPerSecond / 1.0e6, 2) << " M samples/s = "
+              << juce::String (samplesPerSecond / options.hello.sampleRate, 1) << " real-time streams" << std::endl
+              << "latency p50 " << juce::String (getPercentile (latencies, 50.0), 3)
+              << " ms, p99 " << juce::String (getPercentile (latencies, 99.0), 3)
+              << " ms, p99.9 " << juce::String (getPercentile (latencies, 99.9), 3)
+              << " ms, max " << juce::String (latencies.empty() ? 0.0 : latencies.back(), 3) << " ms" << std::endl;
+
+    if (! options.flood)
+        std::cout << numLate << " packets later than one packet period (" << juce::String (packetMs, 1) << " ms)" << std::endl;
+
+    if (numFailed > 0)
+        std::cout << numFailed << " streams failed or were dropped" << std::endl;
+
+    return numFailed > 0 ? 1 : 0;
+}
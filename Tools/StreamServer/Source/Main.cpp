@@ -0,0 +1,1048 @@
+/*
+  ==============================================================================
+
+    Headless stream server for the Vocal Compressor.
+
+    Compresses live mono voice streams without a plugin host, e.g. for a
+    voice chat backend. Clients connect to a Unix domain socket, one
+    connection per stream, and send raw PCM; see StreamProtocol.h.
+
+    One I/O thread reads every connection through epoll and cuts what
+    arrives into blocks. Each stream belongs to one worker of a fixed pool,
+    where it holds a lane of the worker's MultiStreamCompressor for as long
+    as it is connected. A worker collects whichever of its streams have a
+    block waiting and compresses them in one call, passing null for the
+    rest, so the streams that are ready together share SIMD vectors. The
+    more loaded the server, the more streams are waiting each time a worker
+    comes round, and the fuller its vectors get.
+
+    Output goes straight back to the socket from the worker. What the
+    socket does not take is kept and flushed by the I/O thread; a client
+    that stops reading, or sends faster than it is served, is throttled
+    and finally dropped rather than allowed to hold up the others.
+
+    Latency is measured per block, from the arrival of its last sample to
+    its compressed output being handed to the socket.
+
+    Linux only.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <iostream>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "../../../Source/DSP/MultiStreamCompressor.h"
+#include "StreamProtocol.h"
+
+//==============================================================================
+static void printUsage()
+{
+    std::cout << "Usage: VocalCompressorStreamServer [options]\n"
+                 "\n"
+                 "  --socket=<path>          default " << StreamProtocol::defaultSocketPath << "\n"
+                 "  --sample-rate=<Hz>       the rate every stream must use, default 48000\n"
+                 "  --block-size=<n>         samples per processing block, default 480 (10 ms at 48 kHz)\n"
+                 "  --workers=<n>            processing threads, default: one per core, less one for I/O\n"
+                 "  --max-streams=<n>        default 4096\n"
+                 "  --accuracy=<mode>        exact, high or fast, default high\n"
+                 "  --report=<s>             seconds between reports, default 5, 0 for none\n"
+                 "  --list-streams           add every stream's latency to each report\n"
+                 "\n"
+                 "The compressor settings come from each stream's Hello.\n";
+}
+
+static std::atomic<bool> keepRunning { true };
+
+static double getMilliseconds()
+{
+    return juce::Time::getMillisecondCounterHiRes();
+}
+
+//==============================================================================
+struct Options
+{
+    juce::String socketPath = StreamProtocol::defaultSocketPath;
+    int sampleRate = 48000;
+    int blockSize = 480;
+    int numWorkers = 1;
+    int maximumStreams = 4096;
+    VocalDSP::Accuracy accuracy = VocalDSP::Accuracy::high;
+    double reportSeconds = 5.0;
+    bool listStreams = false;
+
+    // Beyond this many blocks in either direction a stream is throttled, then dropped
+    int maximumQueuedBlocks = 50;
+};
+
+struct LatencyStats
+{
+    juce::int64 numBlocks = 0;
+    double totalMs = 0.0, maximumMs = 0.0;
+
+    void add (double ms) noexcept
+    {
+        ++numBlocks;
+        totalMs += ms;
+        maximumMs = juce::jmax (maximumMs, ms);
+    }
+
+    void add (const LatencyStats& other) noexcept
+    {
+        numBlocks += other.numBlocks;
+        totalMs += other.totalMs;
+        maximumMs = juce::jmax (maximumMs, other.maximumMs);
+    }
+
+    double getMeanMs() const noexcept    { return numBlocks > 0 ? totalMs / (double) numBlocks : 0.0; }
+};
+
+struct Block
+{
+    std::vector<float> samples;
+    double arrivalMs = 0.0;
+};
+
+//==============================================================================
+/** One connection. Until its Hello has arrived only the I/O thread knows it. */
+struct Stream
+{
+    Stream (juce::int64 streamId, int socket) : id (streamId), fd (socket) {}
+
+    const juce::int64 id;
+    const int fd;
+
+    // Set once the Hello is accepted
+    StreamProtocol::Format format = StreamProtocol::Format::float32;
+    VocalDSP::Parameters parameters;
+    int worker = -1;
+    int bytesPerBlock = 0;
+
+    // I/O thread only: bytes short of a whole block, and the Hello before that
+    std::vector<char> received;
+    bool accepted = false;
+
+    // Worker only
+    int slot = -1;
+
+    std::mutex lock;
+
+    // Guarded by lock
+    std::deque<Block> ready;
+    std::vector<Block> spare;
+    std::vector<char> unsent;
+    bool scheduled = false;         // queued with its worker
+    bool reading = true;            // watched for input
+    juce::int64 numSamples = 0;
+    LatencyStats latency, latencySinceReport;
+};
+
+using StreamPtr = std::shared_ptr<Stream>;
+
+//==============================================================================
+class Server;
+
+class Worker
+{
+public:
+    Worker (Server& owner, int capacity);
+    ~Worker();
+
+    /** These can be called from any thread. */
+    void add (StreamPtr);
+    void remove (StreamPtr);
+    void schedule (StreamPtr);
+
+    std::atomic<int> numStreams { 0 };
+    std::atomic<juce::int64> busyNanoseconds { 0 };
+
+    const int capacity;
+
+private:
+    void run();
+    void addStream (const StreamPtr&);
+    void removeStream (const StreamPtr&);
+    void processBatch (std::vector<StreamPtr>& streams);
+    void send (Stream&, const Block&);
+
+    Server& server;
+
+    std::mutex lock;
+    std::condition_variable wakeUp;
+    std::vector<StreamPtr> toAdd, toRemove, toProcess;
+
+    // Worker thread only
+    VocalDSP::MultiStreamCompressor compressor;
+    std::vector<StreamPtr> slots;
+    std::priority_queue<int, std::vector<int>, std::greater<int>> freeSlots;
+    std::vector<Block> blocks;
+    std::vector<float*> channels;
+    std::vector<char> output;
+
+    std::thread thread;
+};
+
+//==============================================================================
+class Server
+{
+public:
+    explicit Server (const Options& options);
+    ~Server();
+
+    bool start();
+    void runReports();
+
+    /** Sets what epoll watches a connection for. Call with the stream's lock held. */
+    void watch (Stream&);
+
+    /** Reports on a stream its worker has let go of. */
+    void onStreamClosed (Stream&);
+
+    const Options options;
+    std::atomic<juce::int64> processedSamples { 0 };
+
+private:
+    void runIO();
+    void acceptConnections();
+    void readFrom (const StreamPtr&);
+    bool readHello (const StreamPtr&);
+    StreamProtocol::Status accept (Stream&, const StreamProtocol::Hello&);
+    void reject (Stream&, StreamProtocol::Status);
+    void flush (Stream&);
+    void close (const StreamPtr&);
+
+    void report (double elapsedMs);
+
+    int listener = -1, epoll = -1;
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::thread ioThread;
+
+    // I/O thread only
+    std::map<juce::int64, StreamPtr> connections;
+    juce::int64 nextStreamId = 1;
+    int nextWorker = 0;
+
+    // The accepted streams, for the reports
+    std::mutex streamsLock;
+    std::map<juce::int64, StreamPtr> streams;
+    LatencyStats closedSinceReport;
+    int numClosedSinceReport = 0;
+};
+
+//==============================================================================
+static void convertFromBytes (const char* bytes, float* samples, int numSamples, StreamProtocol::Format format)
+{
+    if (format == StreamProtocol::Format::int16)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            std::int16_t value;
+            std::memcpy (&value, bytes + 2 * i, 2);
+            samples[i] = (float) value * (1.0f / 32768.0f);
+        }
+    }
+    else
+    {
+        std::memcpy (samples, bytes, (size_t) numSamples * 4);
+    }
+}
+
+static void convertToBytes (const float* samples, char* bytes, int numSamples, StreamProtocol::Format format)
+{
+    if (format == StreamProtocol::Format::int16)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto value = (std::int16_t) juce::jlimit (-32768.0f, 32767.0f, std::round (samples[i] * 32768.0f));
+            std::memcpy (bytes + 2 * i, &value, 2);
+        }
+    }
+    else
+    {
+        std::memcpy (bytes, samples, (size_t) numSamples * 4);
+    }
+}
+
+/** Writes what the socket takes without blocking, and returns how much that was. */
+static size_t sendSome (int fd, const char* bytes, size_t size)
+{
+    size_t sent = 0;
+
+    while (sent < size)
+    {
+        const auto result = ::send (fd, bytes + sent, size - sent, MSG_DONTWAIT | MSG_NOSIGNAL);
+
+        if (result > 0)
+            sent += (size_t) result;
+        else if (result < 0 && errno == EINTR)
+            continue;
+        else
+            break;
+    }
+
+    return sent;
+}
+
+//==============================================================================
+Worker::Worker (Server& owner, int maximumStreams)
+    : capacity ((maximumStreams + VocalDSP::MultiStreamCompressor::laneCount - 1)
+                  / VocalDSP::MultiStreamCompressor::laneCount * VocalDSP::MultiStreamCompressor::laneCount),
+      server (owner)
+{
+    const auto& options = server.options;
+
+    compressor.prepare (options.sampleRate, options.blockSize, capacity);
+    compressor.setAccuracy (options.accuracy);
+
+    slots.resize ((size_t) capacity);
+    blocks.resize ((size_t) capacity);
+    channels.assign ((size_t) capacity, nullptr);
+    output.resize ((size_t) options.blockSize * 4);
+
+    // Lowest first, so the streams pack into as few vectors as possible
+    for (int slot = 0; slot < capacity; ++slot)
+        freeSlots.push (slot);
+
+    thread = std::thread ([this] { run(); });
+}
+
+Worker::~Worker()
+{
+    wakeUp.notify_all();
+    thread.join();
+}
+
+void Worker::add (StreamPtr stream)
+{
+    ++numStreams;
+    const std::lock_guard<std::mutex> sl (lock);
+    toAdd.push_back (std::move (stream));
+    wakeUp.notify_one();
+}
+
+void Worker::remove (StreamPtr stream)
+{
+    const std::lock_guard<std::mutex> sl (lock);
+    toRemove.push_back (std::move (stream));
+    wakeUp.notify_one();
+}
+
+void Worker::schedule (StreamPtr stream)
+{
+    const std::lock_guard<std::mutex> sl (lock);
+    toProcess.push_back (std::move (stream));
+    wakeUp.notify_one();
+}
+
+void Worker::run()
+{
+    juce::ScopedNoDenormals noDenormals;
+
+    std::vector<StreamPtr> adding, removing, processing;
+
+    while (keepRunning || ! processing.empty())
+    {
+        {
+            std::unique_lock<std::mutex> sl (lock);
+
+            if (processing.empty() && toAdd.empty() && toRemove.empty() && toProcess.empty())
+                wakeUp.wait_for (sl, std::chrono::milliseconds (100));
+
+            adding.swap (toAdd);
+            removing.swap (toRemove);
+            processing.insert (processing.end(), toProcess.begin(), toProcess.end());
+            toProcess.clear();
+        }
+
+        // A stream is added before it can have a block, so never after its first one here
+        for (auto& stream : adding)
+            addStream (stream);
+
+        for (auto& stream : removing)
+            removeStream (stream);
+
+        adding.clear();
+        removing.clear();
+
+        if (! processing.empty())
+            processBatch (processing);
+    }
+}
+
+void Worker::addStream (const StreamPtr& stream)
+{
+    if (freeSlots.empty())
+    {
+        jassertfalse; // the server only hands out what fits
+        return;
+    }
+
+    const int slot = freeSlots.top();
+    freeSlots.pop();
+
+    stream->slot = slot;
+    slots[(size_t) slot] = stream;
+
+    compressor.setParameters (slot, stream->parameters);
+    compressor.reset (slot);
+}
+
+void Worker::removeStream (const StreamPtr& stream)
+{
+    if (stream->slot >= 0)
+    {
+        slots[(size_t) stream->slot] = nullptr;
+        freeSlots.push (stream->slot);
+        stream->slot = -1;
+    }
+
+    server.onStreamClosed (*stream);
+
+    // Closed here, after the last write, so the descriptor cannot be reused under it
+    ::close (stream->fd);
+    --numStreams;
+}
+
+void Worker::processBatch (std::vector<StreamPtr>& streams)
+{
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+    const int blockSize = server.options.blockSize;
+
+    // One block of every stream that has one, the rest stay null
+    std::vector<StreamPtr> waiting;
+    int numProcessed = 0;
+
+    for (auto& stream : streams)
+    {
+        const std::lock_guard<std::mutex> sl (stream->lock);
+
+        if (stream->slot < 0 || stream->ready.empty())
+        {
+            stream->scheduled = false;
+            continue;
+        }
+
+        auto& block = blocks[(size_t) stream->slot];
+        std::swap (block, stream->ready.front());
+        stream->spare.push_back (std::move (stream->ready.front()));
+        stream->ready.pop_front();
+
+        channels[(size_t) stream->slot] = block.samples.data();
+        ++numProcessed;
+
+        // It was holding back its input while too far behind
+        if (! stream->reading && (int) stream->ready.size() < server.options.maximumQueuedBlocks / 2)
+        {
+            stream->reading = true;
+            server.watch (*stream);
+        }
+
+        if (stream->ready.empty())
+            stream->scheduled = false;
+        else
+            waiting.push_back (stream);
+    }
+
+    compressor.process (channels.data(), blockSize);
+
+    for (auto& stream : streams)
+    {
+        if (stream->slot < 0 || channels[(size_t) stream->slot] == nullptr)
+            continue;
+
+        send (*stream, blocks[(size_t) stream->slot]);
+        channels[(size_t) stream->slot] = nullptr;
+    }
+
+    server.processedSamples += (juce::int64) numProcessed * blockSize;
+    busyNanoseconds += (juce::int64) (juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks) * 1.0e9);
+
+    // Those with more blocks go round again, with whatever arrived meanwhile
+    streams.swap (waiting);
+}
+
+void Worker::send (Stream& stream, const Block& block)
+{
+    const int blockSize = server.options.blockSize;
+    const auto numBytes = (size_t) stream.bytesPerBlock;
+
+    convertToBytes (block.samples.data(), output.data(), blockSize, stream.format);
+
+    const std::lock_guard<std::mutex> sl (stream.lock);
+
+    // Behind what is already waiting, or the order would break
+    const size_t sent = stream.unsent.empty() ? sendSome (stream.fd, output.data(), numBytes) : 0;
+
+    if (sent < numBytes)
+    {
+        stream.unsent.insert (stream.unsent.end(), output.data() + sent, output.data() + numBytes);
+
+        if (stream.unsent.size() > (size_t) server.options.maximumQueuedBlocks * numBytes)
+        {
+            // Not reading its output, the I/O thread sees it hang up
+            ::shutdown (stream.fd, SHUT_RDWR);
+        }
+        else
+        {
+            server.watch (stream);
+        }
+    }
+
+    const double latencyMs = getMilliseconds() - block.arrivalMs;
+    stream.latency.add (latencyMs);
+    stream.latencySinceReport.add (latencyMs);
+    stream.numSamples += blockSize;
+}
+
+//==============================================================================
+Server::Server (const Options& serverOptions)
+    : options (serverOptions)
+{
+}
+
+Server::~Server()
+{
+    keepRunning = false;
+
+    if (ioThread.joinable())
+        ioThread.join();
+
+    workers.clear();
+
+    // Those still connected, the workers are gone
+    for (auto& connection : connections)
+        ::close (connection.second->fd);
+
+    if (epoll >= 0)
+        ::close (epoll);
+
+    if (listener >= 0)
+    {
+        ::close (listener);
+        ::unlink (options.socketPath.toRawUTF8());
+    }
+}
+
+bool Server::start()
+{
+    sockaddr_un address {};
+    address.sun_family = AF_UNIX;
+
+    if (options.socketPath.length() >= (int) sizeof (address.sun_path))
+    {
+        std::cerr << "Socket path too long: " << options.socketPath << std::endl;
+        return false;
+    }
+
+    std::strcpy (address.sun_path, options.socketPath.toRawUTF8());
+
+    // A socket left behind by an earlier run would fail the bind
+    ::unlink (address.sun_path);
+
+    listener = ::socket (AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+    if (listener < 0
+         || ::bind (listener, (const sockaddr*) &address, sizeof (address)) != 0
+         || ::listen (listener, SOMAXCONN) != 0)
+    {
+        std::cerr << "Cannot listen on " << options.socketPath << ": " << std::strerror (errno) << std::endl;
+        return false;
+    }
+
+    epoll = ::epoll_create1 (EPOLL_CLOEXEC);
+
+    epoll_event event {};
+    event.events = EPOLLIN;
+    event.data.u64 = 0;
+
+    if (epoll < 0 || ::epoll_ctl (epoll, EPOLL_CTL_ADD, listener, &event) != 0)
+    {
+        std::cerr << "epoll: " << std::strerror (errno) << std::endl;
+        return false;
+    }
+
+    const int streamsPerWorker = (options.maximumStreams + options.numWorkers - 1) / options.numWorkers;
+
+    for (int i = 0; i < options.numWorkers; ++i)
+        workers.push_back (std::make_unique<Worker> (*this, streamsPerWorker));
+
+    ioThread = std::thread ([this] { runIO(); });
+    return true;
+}
+
+void Server::watch (Stream& stream)
+{
+    epoll_event event {};
+    event.events = EPOLLRDHUP | (stream.reading ? EPOLLIN : 0u) | (stream.unsent.empty() ? 0u : EPOLLOUT);
+    event.data.u64 = (std::uint64_t) stream.id;
+
+    ::epoll_ctl (epoll, EPOLL_CTL_MOD, stream.fd, &event);
+}
+
+//==============================================================================
+void Server::runIO()
+{
+    std::vector<epoll_event> events (1024);
+
+    while (keepRunning)
+    {
+        const int numEvents = ::epoll_wait (epoll, events.data(), (int) events.size(), 100);
+
+        for (int i = 0; i < numEvents; ++i)
+        {
+            const auto& event = events[(size_t) i];
+
+            if (event.data.u64 == 0)
+            {
+                acceptConnections();
+                continue;
+            }
+
+            // Events queued for a connection closed earlier in this batch
+            auto found = connections.find ((juce::int64) event.data.u64);
+
+            if (found == connections.end())
+                continue;
+
+            auto stream = found->second;
+
+            if ((event.events & EPOLLOUT) != 0)
+                flush (*stream);
+
+            if ((event.events & EPOLLIN) != 0)
+                readFrom (stream);
+            else if ((event.events & (EPOLLHUP | EPOLLERR | EPOLLRDHUP)) != 0)
+                close (stream);
+        }
+    }
+}
+
+void Server::acceptConnections()
+{
+    for (;;)
+    {
+        const int fd = ::accept4 (listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+        if (fd < 0)
+            return;
+
+        auto stream = std::make_shared<Stream> (nextStreamId++, fd);
+
+        epoll_event event {};
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.u64 = (std::uint64_t) stream->id;
+
+        if (::epoll_ctl (epoll, EPOLL_CTL_ADD, fd, &event) != 0)
+        {
+            ::close (fd);
+            continue;
+        }
+
+        connections[stream->id] = stream;
+    }
+}
+
+void Server::readFrom (const StreamPtr& stream)
+{
+    char buffer[65536];
+
+    for (;;)
+    {
+        const auto result = ::recv (stream->fd, buffer, sizeof (buffer), 0);
+
+        if (result == 0 || (result < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+        {
+            close (stream);
+            return;
+        }
+
+        if (result < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            return;
+        }
+
+        auto& received = stream->received;
+        received.insert (received.end(), buffer, buffer + result);
+
+        if (! stream->accepted && ! readHello (stream))
+            return;
+
+        if (! stream->accepted || (int) received.size() < stream->bytesPerBlock)
+            continue;
+
+        // Every whole block goes to the worker, stamped with when it was complete
+        const double now = getMilliseconds();
+        const int numBlocks = (int) received.size() / stream->bytesPerBlock;
+        bool schedule = false;
+
+        {
+            const std::lock_guard<std::mutex> sl (stream->lock);
+
+            for (int b = 0; b < numBlocks; ++b)
+            {
+                Block block;
+
+                if (! stream->spare.empty())
+                {
+                    block = std::move (stream->spare.back());
+                    stream->spare.pop_back();
+                }
+
+                block.samples.resize ((size_t) options.blockSize);
+                block.arrivalMs = now;
+                convertFromBytes (received.data() + b * stream->bytesPerBlock, block.samples.data(), options.blockSize, stream->format);
+                stream->ready.push_back (std::move (block));
+            }
+
+            schedule = ! stream->scheduled;
+            stream->scheduled = true;
+
+            // Too far ahead of its worker, leave the rest in the socket for now
+            if ((int) stream->ready.size() >= options.maximumQueuedBlocks)
+            {
+                stream->reading = false;
+                watch (*stream);
+            }
+        }
+
+        received.erase (received.begin(), received.begin() + numBlocks * stream->bytesPerBlock);
+
+        if (schedule)
+            workers[(size_t) stream->worker]->schedule (stream);
+
+        if (! stream->reading)
+            return;
+    }
+}
+
+bool Server::readHello (const StreamPtr& stream)
+{
+    using namespace StreamProtocol;
+
+    auto& received = stream->received;
+
+    if (received.size() < sizeof (Hello))
+        return true;
+
+    Hello hello;
+    std::memcpy (&hello, received.data(), sizeof (Hello));
+    received.erase (received.begin(), received.begin() + (int) sizeof (Hello));
+
+    const auto status = accept (*stream, hello);
+
+    if (status != Status::accepted)
+    {
+        reject (*stream, status);
+        return false;
+    }
+
+    Accept reply;
+    reply.sampleRate = (std::uint32_t) options.sampleRate;
+    reply.blockSize = (std::uint32_t) options.blockSize;
+
+    {
+        const std::lock_guard<std::mutex> sl (stream->lock);
+        stream->unsent.assign ((const char*) &reply, (const char*) &reply + sizeof (reply));
+    }
+
+    flush (*stream);
+
+    {
+        const std::lock_guard<std::mutex> sl (streamsLock);
+        streams[stream->id] = stream;
+    }
+
+    workers[(size_t) stream->worker]->add (stream);
+    return true;
+}
+
+StreamProtocol::Status Server::accept (Stream& stream, const StreamProtocol::Hello& hello)
+{
+    using namespace StreamProtocol;
+
+    const float settings[] = { hello.threshold, hello.ratio, hello.attack, hello.release, hello.knee, hello.autoGain };
+
+    if (hello.magic != helloMagic || ! std::all_of (std::begin (settings), std::end (settings), [] (float x) { return std::isfinite (x); }))
+        return Status::badHello;
+
+    if (hello.version != version)
+        return Status::unsupportedVersion;
+
+    if (hello.format != (std::uint16_t) Format::float32 && hello.format != (std::uint16_t) Format::int16)
+        return Status::unsupportedFormat;
+
+    if ((int) hello.sampleRate != options.sampleRate)
+        return Status::wrongSampleRate;
+
+    {
+        const std::lock_guard<std::mutex> sl (streamsLock);
+
+        if ((int) streams.size() >= options.maximumStreams)
+            return Status::serverFull;
+    }
+
+    // The least loaded worker with room, starting after the last one picked
+    int worker = -1;
+
+    for (int i = 0; i < (int) workers.size(); ++i)
+    {
+        const int candidate = (nextWorker + i) % (int) workers.size();
+        const int load = workers[(size_t) candidate]->numStreams;
+
+        if (load < workers[(size_t) candidate]->capacity
+             && (worker < 0 || load < workers[(size_t) worker]->numStreams))
+            worker = candidate;
+    }
+
+    if (worker < 0)
+        return Status::serverFull;
+
+    nextWorker = (worker + 1) % (int) workers.size();
+
+    // Held to the plugin's parameter ranges
+    stream.format = (Format) hello.format;
+    stream.parameters.threshold = juce::jlimit (-60.0f, 0.0f, hello.threshold);
+    stream.parameters.ratio = juce::jlimit (1.0f, 20.0f, hello.ratio);
+    stream.parameters.attack = juce::jlimit (0.0f, 50.0f, hello.attack);
+    stream.parameters.release = juce::jlimit (0.0f, 1000.0f, hello.release);
+    stream.parameters.knee = juce::jlimit (0.0f, 96.0f, hello.knee);
+    stream.parameters.autoGain = juce::jlimit (0.0f, 1.0f, hello.autoGain);
+    stream.worker = worker;
+    stream.bytesPerBlock = options.blockSize * getBytesPerSample (stream.format);
+    stream.accepted = true;
+
+    return Status::accepted;
+}
+
+void Server::reject (Stream& stream, StreamProtocol::Status status)
+{
+    StreamProtocol::Accept reply;
+    reply.status = (std::uint32_t) status;
+    reply.sampleRate = (std::uint32_t) options.sampleRate;
+    reply.blockSize = (std::uint32_t) options.blockSize;
+
+    sendSome (stream.fd, (const char*) &reply, sizeof (reply));
+    ::epoll_ctl (epoll, EPOLL_CTL_DEL, stream.fd, nullptr);
+    ::close (stream.fd);
+    connections.erase (stream.id);
+}
+
+void Server::flush (Stream& stream)
+{
+    const std::lock_guard<std::mutex> sl (stream.lock);
+
+    auto& unsent = stream.unsent;
+    const auto sent = sendSome (stream.fd, unsent.data(), unsent.size());
+    unsent.erase (unsent.begin(), unsent.begin() + (std::ptrdiff_t) sent);
+    watch (stream);
+}
+
+void Server::close (const StreamPtr& stream)
+{
+    ::epoll_ctl (epoll, EPOLL_CTL_DEL, stream->fd, nullptr);
+    connections.erase (stream->id);
+
+    if (! stream->accepted)
+    {
+        ::close (stream->fd);
+        return;
+    }
+
+    // The worker closes the descriptor once it is done with it
+    workers[(size_t) stream->worker]->remove (stream);
+}
+
+void Server::onStreamClosed (Stream& stream)
+{
+    LatencyStats latency;
+    juce::int64 numSamples;
+
+    {
+        const std::lock_guard<std::mutex> sl (stream.lock);
+        latency = stream.latency;
+        numSamples = stream.numSamples;
+
+        const std::lock_guard<std::mutex> sl2 (streamsLock);
+        closedSinceReport.add (stream.latencySinceReport);
+        ++numClosedSinceReport;
+        streams.erase (stream.id);
+    }
+
+    std::cout << "stream " << stream.id << " closed: "
+              << juce::String ((double) numSamples / options.sampleRate, 1) << " s, latency mean "
+              << juce::String (latency.getMeanMs(), 3) << " ms, max "
+              << juce::String (latency.maximumMs, 3) << " ms" << std::endl;
+}
+
+//==============================================================================
+void Server::runReports()
+{
+    auto lastReport = getMilliseconds();
+
+    while (keepRunning)
+    {
+        std::this_thread::sleep_for (std::chrono::milliseconds (100));
+
+        const auto now = getMilliseconds();
+
+        if (options.reportSeconds > 0.0 && now - lastReport >= options.reportSeconds * 1000.0)
+        {
+            report (now - lastReport);
+            lastReport = now;
+        }
+    }
+}
+
+void Server::report (double elapsedMs)
+{
+    std::vector<StreamPtr> active;
+    LatencyStats latency;
+    int numClosed;
+
+    {
+        const std::lock_guard<std::mutex> sl (streamsLock);
+
+        for (auto& stream : streams)
+            active.push_back (stream.second);
+
+        latency = closedSinceReport;
+        numClosed = numClosedSinceReport;
+        closedSinceReport = {};
+        numClosedSinceReport = 0;
+    }
+
+    juce::int64 worstStream = 0;
+    double worstMs = 0.0;
+
+    for (auto& stream : active)
+    {
+        LatencyStats sinceReport;
+
+        {
+            const std::lock_guard<std::mutex> sl (stream->lock);
+            sinceReport = stream->latencySinceReport;
+            stream->latencySinceReport = {};
+        }
+
+        if (sinceReport.maximumMs > worstMs)
+        {
+            worstMs = sinceReport.maximumMs;
+            worstStream = stream->id;
+        }
+
+        latency.add (sinceReport);
+
+        if (options.listStreams)
+            std::cout << "  stream " << stream->id << ": " << sinceReport.numBlocks << " blocks, latency mean "
+                      << juce::String (sinceReport.getMeanMs(), 3) << " ms, max "
+                      << juce::String (sinceReport.maximumMs, 3) << " ms" << std::endl;
+    }
+
+    juce::int64 busyNanoseconds = 0;
+
+    for (auto& worker : workers)
+        busyNanoseconds += worker->busyNanoseconds.exchange (0);
+
+    const auto samples = processedSamples.exchange (0);
+    const auto samplesPerSecond = (double) samples * 1000.0 / elapsedMs;
+
+    std::cout << active.size() << " streams (" << numClosed << " closed), "
+              << juce::String (samplesPerSecond / 1.0e6, 2) << " M samples/s = "
+              << juce::String (samplesPerSecond / options.sampleRate, 1) << " real-time streams, workers "
+              << juce::String (100.0 * (double) busyNanoseconds / (elapsedMs * 1.0e6 * (double) workers.size()), 1) << "% busy, latency mean "
+              << juce::String (latency.getMeanMs(), 3) << " ms, max "
+              << juce::String (latency.maximumMs, 3) << " ms";
+
+    if (worstStream != 0)
+        std::cout << " (stream " << worstStream << ")";
+
+    std::cout << std::endl;
+}
+
+//==============================================================================
+static void stop (int)
+{
+    keepRunning = false;
+}
+
+int main (int argc, char* argv[])
+{
+    juce::ArgumentList args (argc, argv);
+
+    if (args.containsOption ("--help|-h"))
+    {
+        printUsage();
+        return 0;
+    }
+
+    Options options;
+    options.numWorkers = juce::jmax (1, juce::SystemStats::getNumCpus() - 1);
+
+    if (args.containsOption ("--socket"))
+        options.socketPath = args.getValueForOption ("--socket");
+
+    if (args.containsOption ("--sample-rate"))
+        options.sampleRate = juce::jlimit (8000, 384000, args.getValueForOption ("--sample-rate").getIntValue());
+
+    if (args.containsOption ("--block-size"))
+        options.blockSize = juce::jlimit (16, 16384, args.getValueForOption ("--block-size").getIntValue());
+
+    if (args.containsOption ("--workers"))
+        options.numWorkers = juce::jlimit (1, 256, args.getValueForOption ("--workers").getIntValue());
+
+    if (args.containsOption ("--max-streams"))
+        options.maximumStreams = juce::jmax (1, args.getValueForOption ("--max-streams").getIntValue());
+
+    if (args.containsOption ("--accuracy"))
+    {
+        const auto mode = args.getValueForOption ("--accuracy");
+        options.accuracy = mode == "exact" ? VocalDSP::Accuracy::exact
+                         : mode == "fast"  ? VocalDSP::Accuracy::fast
+                                           : VocalDSP::Accuracy::high;
+    }
+
+    if (args.containsOption ("--report"))
+        options.reportSeconds = juce::jmax (0.0, args.getValueForOption ("--report").getDoubleValue());
+
+    options.listStreams = args.containsOption ("--list-streams");
+
+    std::signal (SIGINT, stop);
+    std::signal (SIGTERM, stop);
+    std::signal (SIGPIPE, SIG_IGN);
+
+    Server server (options);
+
+    if (! server.start())
+        return 1;
+
+    std::cout << "Listening on " << options.socketPath << ", " << options.sampleRate << " Hz, blocks of "
+              << options.blockSize << ", " << options.numWorkers << " workers" << std::endl;
+
+    server.runReports();
+    return 0;
+}
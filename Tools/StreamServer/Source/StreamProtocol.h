@@ -0,0 +1,83 @@
+/*
+  ==============================================================================
+
+    StreamProtocol.h
+
+    The wire format between the stream server and its clients. Every
+    connection to the server's Unix domain socket carries one mono stream:
+
+        client  ->  server      Hello, then raw PCM for as long as it likes
+        server  ->  client      Accept, then the compressed PCM
+
+    Both directions use the sample format named in the Hello. The server
+    compresses whole blocks of Accept::blockSize samples and answers each
+    block as soon as it is done, so a client sending 10 ms packets gets 10
+    ms packets back, one block after it sent them; a partial block waits
+    for the rest. Closing the connection ends the stream.
+
+    Everything is in the host's byte order, as both ends share a machine.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cstdint>
+
+namespace StreamProtocol
+{
+    constexpr std::uint32_t helloMagic  = 0x48535356;   // "VSSH"
+    constexpr std::uint32_t acceptMagic = 0x41535356;   // "VSSA"
+    constexpr std::uint16_t version = 1;
+
+    constexpr const char* defaultSocketPath = "/tmp/vocal-compressor.sock";
+
+    enum class Format : std::uint16_t
+    {
+        float32 = 0,
+        int16   = 1
+    };
+
+    inline int getBytesPerSample (Format format) noexcept
+    {
+        return format == Format::int16 ? 2 : 4;
+    }
+
+    /** The first thing a client sends. The settings follow VocalDSP::Parameters. */
+    struct Hello
+    {
+        std::uint32_t magic = helloMagic;
+        std::uint16_t version = StreamProtocol::version;
+        std::uint16_t format = (std::uint16_t) Format::float32;
+        std::uint32_t sampleRate = 48000;
+
+        float threshold = -18.0f;
+        float ratio = 4.0f;
+        float attack = 5.0f;
+        float release = 250.0f;
+        float knee = 18.0f;
+        float autoGain = 0.5f;
+    };
+
+    enum class Status : std::uint32_t
+    {
+        accepted = 0,
+        badHello,
+        unsupportedVersion,
+        unsupportedFormat,
+        wrongSampleRate,
+        serverFull
+    };
+
+    /** The server's answer. Anything but Status::accepted is followed by the connection closing. */
+    struct Accept
+    {
+        std::uint32_t magic = acceptMagic;
+        std::uint32_t status = (std::uint32_t) Status::accepted;
+        std::uint32_t sampleRate = 0;
+        std::uint32_t blockSize = 0;
+    };
+
+    static_assert (sizeof (Hello) == 36, "Hello is sent as it is laid out");
+    static_assert (sizeof (Accept) == 16, "Accept is sent as it is laid out");
+}